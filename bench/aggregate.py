@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
-"""Aggregate bench CSV: seed,cap,created,discovered,completed,exhausted,end_time"""
+"""Aggregate bench CSV: seed,cap,created,discovered,completed,exhausted,end_time,
+workerE,droneE,drone_cell_cost[,p50_us,p99_us,p999_us,max_us[,info_...,decide_...,delta_...]]"""
 import sys
 import statistics as st
 
@@ -17,6 +18,9 @@ for line in open(path):
         "exhausted": int(parts[5]), "end_time": int(parts[6]),
         "workerE": int(parts[7]) if len(parts) > 7 else -1,
         "droneE": int(parts[8]) if len(parts) > 8 else -1,
+        "lat": [int(x) for x in parts[10:14]] if len(parts) > 13 else None,
+        # per callback: on_info_updated, decide_all, on_delta (4 columns each)
+        "cb": [[int(x) for x in parts[i:i + 4]] for i in range(14, len(parts) - 3, 4)],
     })
 
 n = len(rows)
@@ -46,6 +50,25 @@ if we:
 missed = [r["created"] - r["discovered"] for r in rows]
 undone = [r["discovered"] - r["completed"] for r in rows]
 print(f"not discovered: mean={st.mean(missed):.2f}  discovered-but-not-done: mean={st.mean(undone):.2f}")
+lat = [r for r in rows if r["lat"]]
+if lat:
+    # per-seed tick latency percentiles (us); the tail is what a budget breaks on
+    p50 = [r["lat"][0] for r in lat]
+    p99 = [r["lat"][1] for r in lat]
+    p999 = [r["lat"][2] for r in lat]
+    worst = max(lat, key=lambda r: r["lat"][3])
+    print(f"tick latency us: p50 median={st.median(p50):.0f}  p99 median={st.median(p99):.0f} max={max(p99)}  "
+          f"p99.9 median={st.median(p999):.0f} max={max(p999)}  max={worst['lat'][3]} (seed {worst['seed']})")
+    for k, name in enumerate(["on_info_updated", "decide_all", "on_delta"]):
+        cb = [r for r in lat if len(r["cb"]) > k]
+        if not cb:
+            break
+        p50 = [r["cb"][k][0] for r in cb]
+        p99 = [r["cb"][k][1] for r in cb]
+        p999 = [r["cb"][k][2] for r in cb]
+        worst = max(cb, key=lambda r: r["cb"][k][3])
+        print(f"  {name:<15} us: p50 median={st.median(p50):.0f}  p99 median={st.median(p99):.0f} max={max(p99)}  "
+              f"p99.9 median={st.median(p999):.0f} max={max(p999)}  max={worst['cb'][k][3]} (seed {worst['seed']})")
 hist = {}
 for c in comp:
     hist[c] = hist.get(c, 0) + 1
@@ -1,13 +1,37 @@
-// Benchmark harness: exact replica of the simulation loop in main.cpp,
-// but with (seed, max task cap) taken from argv and a single machine-readable
-// CSV result line on stdout.
+// Benchmark harness: the SIMULATION engine main.cpp runs, with (seed, max
+// task cap) taken from argv and a single machine-readable CSV result line on
+// stdout.
 //
-// Usage: ./bench <seed> [num_max_tasks=20]
-// Output: seed,cap,created,discovered,completed,exhausted,end_time
-#include "../../simulator.h"
-#include "../../schedular.h"
+// Usage: ./bench <seed> [num_max_tasks=20] [mode]
+//        ./bench --seeds <first_seed> <count> [num_max_tasks=20] [mode]
+// Output: seed,cap,created,discovered,completed,exhausted,end_time,
+//         worker_energy,drone_energy,drone_cell_cost,p50_us,p99_us,p999_us,max_us,
+//         info_p50_us,info_p99_us,info_p999_us,info_max_us,
+//         decide_p50_us,decide_p99_us,decide_p999_us,decide_max_us,
+//         delta_p50_us,delta_p99_us,delta_p999_us,delta_max_us
+// Each group of four is a per-tick latency over the run, from an HDR-style
+// histogram: first every callback of a tick together, then on_info_updated,
+// decide_all (with any robot the loop asks again) and on_delta on their own.
+//
+// --seeds runs a whole seed range in this one process on BENCH_JOBS threads
+// (default: every core), each seed with its own MAP, Scheduler and random
+// sequence.  Seeds are handed to whichever thread is free next, and their
+// output is printed in seed order, byte for byte what one process per seed
+// would have printed.  A verbose dump (any other mode) runs the seeds one
+// after another.
+//
+// BENCH_PROFILE=<file> also writes the scheduler's per-tick profile (time per
+// on_info_updated phase, in ns, and its work counters; see tick_profile.h) to
+// <file>: one JSON object per line when the name ends in .json, CSV otherwise.
+// Rows come in seed order, then tick order.
+#include "../simulator.h"
+#include "../schedular.h"
+#include "../simulation.h"
+#include "../thread_pool.h"
 #include <cstdlib>
 #include <climits>
+#include <fstream>
+#include <mutex>
 #include <queue>
 
 
@@ -57,22 +81,63 @@ static vector<int> true_dijkstra(MAP &map, int n, Coord src, ROBOT::TYPE type)
     return d;
 }
 
-int main(int argc, char **argv)
+static bool ends_with(const string &s, const string &suffix)
 {
-    unsigned int seed = (argc > 1) ? static_cast<unsigned int>(strtoul(argv[1], nullptr, 10)) : 0u;
-    const int NUM_MAX_TASKS = (argc > 2) ? atoi(argv[2]) : 20;
-    const bool ORACLE = (argc > 3) && string(argv[3]) == string("oracle");
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static void write_profile_header(ostream &os, bool json)
+{
+    if (json)
+        return;
+    os << "seed,tick";
+    for (int p = 0; p < TickProfile::NUM_PHASES; ++p)
+        os << "," << TickProfile::phase_name(p) << "_ns";
+    os << ",total_ns";
+    for (int c = 0; c < TickProfile::NUM_COUNTERS; ++c)
+        os << "," << TickProfile::counter_name(c);
+    os << "\n";
+}
+
+static void write_profile_row(ostream &os, bool json, unsigned int seed, int tick, const TickProfile &prof)
+{
+    if (json)
+    {
+        os << "{\"seed\":" << seed << ",\"tick\":" << tick << ",\"ns\":{";
+        for (int p = 0; p < TickProfile::NUM_PHASES; ++p)
+            os << (p ? "," : "") << "\"" << TickProfile::phase_name(p) << "\":" << prof.ns(p);
+        os << "},\"total_ns\":" << prof.total_ns() << ",\"counters\":{";
+        for (int c = 0; c < TickProfile::NUM_COUNTERS; ++c)
+            os << (c ? "," : "") << "\"" << TickProfile::counter_name(c) << "\":" << prof.count(c);
+        os << "}}\n";
+        return;
+    }
+    os << seed << "," << tick;
+    for (int p = 0; p < TickProfile::NUM_PHASES; ++p)
+        os << "," << prof.ns(p);
+    os << "," << prof.total_ns();
+    for (int c = 0; c < TickProfile::NUM_COUNTERS; ++c)
+        os << "," << prof.count(c);
+    os << "\n";
+}
+
+// One full simulation of `seed`; everything it prints goes to `out`, and the
+// per-tick profile rows to `profile` when it is given.
+static int run_seed(unsigned int seed, const int NUM_MAX_TASKS, const string &mode, ostream &out,
+                    ostream *profile = nullptr, bool profile_json = false)
+{
+    const bool ORACLE = mode == "oracle";
     // "bound": run normally, then solve exactly for the best completion count
     // that was ever available GIVEN the discovery times this run produced,
     // with free optimal routing and no charge for observation.
-    const bool BOUND = (argc > 3) && string(argv[3]) == string("bound");
+    const bool BOUND = mode == "bound";
     // "terrain": reveal the MAP but not the tasks.  The scheduler starts knowing
     // every wall and every cell cost, while task discovery still has to be
     // earned exactly as before.  This separates the two things `oracle` conflates
     // -- knowing the layout, and knowing where the work is -- and it is the
     // diagnostic that says whether a smarter scout *route* is reachable at all,
     // since any route planner is only as good as the map it plans on.
-    const bool TERRAIN = (argc > 3) && string(argv[3]) == string("terrain");
+    const bool TERRAIN = mode == "terrain";
     const bool NOFORE = getenv("BENCH_BOUND_NOFORE") != nullptr;
 
     constexpr int MAP_SIZE = 20;
@@ -84,20 +149,23 @@ int main(int argc, char **argv)
     // constraint?" without touching the scheduler.  100 = the real rules.
     const int ROBOT_ENERGY = TIME_MAX * 6 *
                              (getenv("BENCH_ENERGY_PCT") ? atoi(getenv("BENCH_ENERGY_PCT")) : 100) / 100;
-    set<Coord> observed_coords;
-    set<Coord> updated_coords;
-
-    srand(seed);
-
-    TIMER timer;
-    MAP map(MAP_SIZE, NUM_ROBOT, NUM_INITIAL_TASKS, NUM_MAX_TASKS, WALL_DENSITY, ROBOT_ENERGY);
-    int time = -1;
+    // BENCH_RNG=xoshiro draws the instance from xoshiro256** instead of the
+    // glibc-compatible stream every recorded result was produced with
+    const char *rng_kind = getenv("BENCH_RNG");
+    SIMULATION::CONFIG config;
+    config.map_size = MAP_SIZE;
+    config.num_robot = NUM_ROBOT;
+    config.num_max_tasks = NUM_MAX_TASKS;
+    config.num_initial_tasks = NUM_INITIAL_TASKS;
+    config.wall_density = WALL_DENSITY;
+    config.time_max = TIME_MAX;
+    config.robot_energy = ROBOT_ENERGY;
+    config.rng = RNG(seed, rng_kind && string(rng_kind) == "xoshiro" ? RNG::KIND::XOSHIRO : RNG::KIND::GLIBC);
+    SIMULATION sim(config);
+    MAP &map = sim.map();
     auto &robots = map.get_robots();
-    auto &known_cost_map = map.get_known_cost_map();
     auto &known_object_map = map.get_known_object_map();
     auto &active_tasks = map.get_active_tasks();
-    Scheduler scheduler;
-    TASKDISPATCHER taskdispatcher(map, TIME_MAX);
     vector<Coord> w0pos;
     vector<int> w0type;
     for (auto &r : robots)
@@ -136,31 +204,24 @@ int main(int argc, char **argv)
         // the scheduler knows the layout and nothing about the work.  A task on
         // a restored cell is re-discovered normally, because update_coords only
         // fires when the known object lacks the TASK bit.
-        set<Coord> all;
-        for (int x = 0; x < MAP_SIZE; ++x)
-            for (int y = 0; y < MAP_SIZE; ++y)
-                all.emplace(x, y);
+        CELL_BITMAP all(MAP_SIZE);
+        all.fill();
         map.update_coords(all);
         for (int x = 0; x < MAP_SIZE; ++x)
             for (int y = 0; y < MAP_SIZE; ++y)
                 if (known_object_map[x][y] != OBJECT::WALL)
                     known_object_map[x][y] = OBJECT::UNKNOWN;
-        active_tasks.clear();
+        map.clear_active_tasks();
     }
 
-    while (++time < TIME_MAX &&
-           robots.size() != map.get_exhausted_robot_num() &&
-           map.num_total_task != map.get_completed_task_num())
-    {
-        taskdispatcher.try_dispatch(time);
+    sim.hooks.after_dispatch = [&](SIMULATION &) {
+        const int time = sim.time();
         track(time);
         if (ORACLE) // diagnostic: perfect information — every cell observed
         {
-            observed_coords.clear();
-            for (int x = 0; x < MAP_SIZE; ++x)
-                for (int y = 0; y < MAP_SIZE; ++y)
-                    observed_coords.emplace(x, y);
-            map.update_coords(observed_coords);
+            CELL_BITMAP all(MAP_SIZE);
+            all.fill();
+            map.update_coords(all);
         }
         if (time % 50 == 0)
         {
@@ -195,83 +256,22 @@ int main(int argc, char **argv)
                 }
             }
         }
-        observed_coords = map.observed_coord_by_robot();
-        for (auto &c : observed_coords)
-            cell_last_seen[c.x][c.y] = time;
-        updated_coords = map.update_coords(observed_coords);
-
-        timer.start();
-        scheduler.on_info_updated(observed_coords,
-                                  updated_coords,
-                                  known_cost_map,
-                                  known_object_map,
-                                  active_tasks,
-                                  robots);
-        timer.stop();
-        for (auto robot : robots)
-        {
-            auto &status = robot->get_status();
-            if (status == ROBOT::STATUS::IDLE)
-            {
-                auto coord = robot->get_coord();
-                bool do_task = false;
-                weak_ptr<TASK> task;
-                if (bool(known_object_map[coord.x][coord.y] & OBJECT::TASK))
-                {
-                    task = map.task_at(coord);
-                    timer.start();
-                    do_task = scheduler.on_task_reached(observed_coords,
-                                                        updated_coords,
-                                                        known_cost_map,
-                                                        known_object_map,
-                                                        active_tasks,
-                                                        robots,
-                                                        *robot,
-                                                        *(task.lock()));
-                    timer.stop();
-                }
-
-                if (do_task)
-                {
-                    robot->start_working(task);
-                }
-                else
-                {
-                    timer.start();
-                    ROBOT::ACTION action = scheduler.idle_action(observed_coords,
-                                                                 updated_coords,
-                                                                 known_cost_map,
-                                                                 known_object_map,
-                                                                 active_tasks,
-                                                                 robots,
-                                                                 *robot);
-                    timer.stop();
-                    robot->start_moving(action);
-                }
-            }
-
-            if (status == ROBOT::STATUS::MOVING)
-            {
-                robot->move();
-            }
-            else if (status == ROBOT::STATUS::WORKING)
-            {
-                robot->work();
-            }
-        }
-    }
+    };
+    sim.hooks.after_observe = [&](SIMULATION &) {
+        for (const Coord c : sim.observed())
+            cell_last_seen[c.x][c.y] = sim.time();
+    };
+    if (profile)
+        sim.hooks.after_tick = [&](SIMULATION &) {
+            write_profile_row(*profile, profile_json, seed, sim.time(), sim.scheduler().profile());
+        };
+    const SIMULATION::RESULT res = sim.run();
+    const int time = res.end_time;
 
-    int completed = map.get_completed_task_num();
-    int discovered = completed + static_cast<int>(active_tasks.size());
-    int created = static_cast<int>(map.get_tasks().size());
-    int worker_energy = 0, drone_energy = 0;
-    for (auto &r : robots)
-    {
-        if (r->type == ROBOT::TYPE::DRONE)
-            drone_energy += r->get_energy();
-        else
-            worker_energy += r->get_energy();
-    }
+    int completed = res.completed;
+    int discovered = res.discovered;
+    int created = res.created;
+    int worker_energy = res.worker_energy, drone_energy = res.drone_energy;
     int drone_cell_cost = -1;
     for (int x = 0; x < MAP_SIZE && drone_cell_cost < 0; ++x)
         for (int y = 0; y < MAP_SIZE; ++y)
@@ -283,21 +283,23 @@ int main(int argc, char **argv)
                 break;
             }
         }
-    cout << seed << "," << NUM_MAX_TASKS << "," << created << "," << discovered
+    out << seed << "," << NUM_MAX_TASKS << "," << created << "," << discovered
          << "," << completed << "," << map.get_exhausted_robot_num() << "," << time
-         << "," << worker_energy << "," << drone_energy << "," << drone_cell_cost << endl;
+         << "," << worker_energy << "," << drone_energy << "," << drone_cell_cost;
+    for (const LatencyHistogram *h : {&res.tick_latency, &res.info_latency, &res.decide_latency, &res.delta_latency})
+        out << "," << h->percentile(0.50) / 1000 << "," << h->percentile(0.99) / 1000 << ","
+            << h->percentile(0.999) / 1000 << "," << h->max() / 1000;
+    out << endl;
 
     if (TERRAIN)
         return 0; // the CSV line above is the whole result
 
     if (BOUND)
     {
-        set<Coord> all;
-        for (int x = 0; x < MAP_SIZE; ++x)
-            for (int y = 0; y < MAP_SIZE; ++y)
-                all.emplace(x, y);
+        CELL_BITMAP all(MAP_SIZE);
+        all.fill();
         map.update_coords(all);
-        const vector<vector<vector<int>>> &cm = map.get_known_cost_map();
+        const GRID<int> &cm = map.get_known_cost_map();
         auto &ts = map.get_tasks();
         int nt = static_cast<int>(ts.size());
         int NW = static_cast<int>(w0pos.size());
@@ -401,11 +403,11 @@ int main(int argc, char **argv)
         }
         int bnd = 0;
         for (int S = 0; S < FULLM; ++S) if (dp[S] > bnd) bnd = dp[S];
-        cout << "BOUND," << seed << "," << completed << "," << discovered << "," << bnd << endl;
+        out << "BOUND," << seed << "," << completed << "," << discovered << "," << bnd << endl;
         return 0;
     }
 
-    if (argc > 3) // verbose dump for failure analysis
+    if (!mode.empty()) // verbose dump for failure analysis
     {
         // per-robot economics: energy spent vs tasks completed
         {
@@ -413,11 +415,11 @@ int main(int argc, char **argv)
             for (auto &tp : map.get_tasks())
                 if (tp->is_done() && tp->get_assigned_robot_id() >= 0)
                     done_by[tp->get_assigned_robot_id()]++;
-            cout << "robot economics (id type spent done spent/task):" << endl;
+            out << "robot economics (id type spent done spent/task):" << endl;
             for (auto &r : robots)
             {
                 int spent = ROBOT_ENERGY - r->get_energy();
-                cout << "  R" << r->id << " " << to_string(r->type)[0]
+                out << "  R" << r->id << " " << to_string(r->type)[0]
                      << " spent=" << spent << " done=" << done_by[r->id]
                      << " per=" << (done_by[r->id] ? spent / done_by[r->id] : -1) << endl;
             }
@@ -425,9 +427,9 @@ int main(int argc, char **argv)
         track(time);
         int unknown_cells = 0;
         auto &kom = map.get_known_object_map();
-        for (auto &col : kom)
-            for (auto &o : col)
-                if (o == OBJECT::UNKNOWN)
+        for (int x = 0; x < MAP_SIZE; ++x)
+            for (int y = 0; y < MAP_SIZE; ++y)
+                if (kom[x][y] == OBJECT::UNKNOWN)
                     ++unknown_cells;
         {
             // Of the cells never observed, how many were actually open ground?
@@ -439,16 +441,14 @@ int main(int argc, char **argv)
                 for (int y = 0; y < MAP_SIZE; ++y)
                     if (kom[x][y] == OBJECT::UNKNOWN)
                         unk.emplace_back(x, y);
-            set<Coord> all;
-            for (int x = 0; x < MAP_SIZE; ++x)
-                for (int y = 0; y < MAP_SIZE; ++y)
-                    all.emplace(x, y);
+            CELL_BITMAP all(MAP_SIZE);
+            all.fill();
             map.update_coords(all);
             int unk_open = 0;
             for (size_t q = 0; q < unk.size(); ++q)
                 if (map.get_cost(unk[q], ROBOT::TYPE::CATERPILLAR) != INFINITE)
                     ++unk_open;
-            cout << "unknown cells at end: " << unknown_cells << "/" << MAP_SIZE * MAP_SIZE
+            out << "unknown cells at end: " << unknown_cells << "/" << MAP_SIZE * MAP_SIZE
                  << " (non-wall: " << unk_open << ")" << endl;
         }
         {
@@ -462,10 +462,10 @@ int main(int argc, char **argv)
                     ++hole;
                 else if (ls < spawn_time[tp->id])
                     ++timing;
-                cout << "  MISS T" << tp->id << " spawn=" << spawn_time[tp->id]
+                out << "  MISS T" << tp->id << " spawn=" << spawn_time[tp->id]
                      << " cell_last_seen=" << ls << " " << tp->coord << endl;
             }
-            cout << "undiscovered: coverage_hole=" << hole << " timing_miss=" << timing << endl;
+            out << "undiscovered: coverage_hole=" << hole << " timing_miss=" << timing << endl;
             int A = 0, B = 0, C = 0;
             for (auto &tp : map.get_tasks())
             {
@@ -478,13 +478,13 @@ int main(int argc, char **argv)
                 else
                     ++B; // was affordable but never served
             }
-            cout << "undone classification: A_never_affordable=" << A
+            out << "undone classification: A_never_affordable=" << A
                  << " B_affordable_unserved=" << B << " C_late_discovery=" << C << endl;
         }
-        cout << "task id: spawn_t disc_t done aff[first,last,dur] coord cost(cat/wheel)" << endl;
+        out << "task id: spawn_t disc_t done aff[first,last,dur] coord cost(cat/wheel)" << endl;
         auto &tasks = map.get_tasks();
         for (auto &tp : tasks)
-            cout << "  T" << tp->id << ": " << spawn_time[tp->id] << " " << disc_time[tp->id]
+            out << "  T" << tp->id << ": " << spawn_time[tp->id] << " " << disc_time[tp->id]
                  << " " << (tp->is_done() ? "DONE" : "----")
                  << " [" << first_affordable[tp->id] << "," << last_affordable[tp->id]
                  << "," << affordable_ticks[tp->id] << "] " << tp->coord
@@ -495,3 +495,61 @@ int main(int argc, char **argv)
     }
     return 0;
 }
+
+int main(int argc, char **argv)
+{
+    const char *profile_path = getenv("BENCH_PROFILE");
+    ofstream profile_file;
+    const bool profile_json = profile_path && ends_with(profile_path, ".json");
+    if (profile_path)
+    {
+        profile_file.open(profile_path);
+        write_profile_header(profile_file, profile_json);
+    }
+    ostream *profile = profile_path ? &profile_file : nullptr;
+
+    if (argc > 1 && string(argv[1]) == string("--seeds"))
+    {
+        const unsigned int first = (argc > 2) ? static_cast<unsigned int>(strtoul(argv[2], nullptr, 10)) : 1u;
+        const int count = (argc > 3) ? atoi(argv[3]) : 1;
+        const int cap = (argc > 4) ? atoi(argv[4]) : 20;
+        const string mode = (argc > 5) ? argv[5] : "";
+        int jobs = getenv("BENCH_JOBS") ? atoi(getenv("BENCH_JOBS")) : static_cast<int>(thread::hardware_concurrency());
+        // the verbose dump prints the map straight to stdout, so it only
+        // stays readable one seed at a time
+        if (jobs < 1 || (!mode.empty() && mode != "bound" && mode != "terrain"))
+            jobs = 1;
+        if (jobs == 1)
+        {
+            for (int i = 0; i < count; ++i)
+                run_seed(first + i, cap, mode, cout, profile, profile_json);
+            return 0;
+        }
+        vector<string> result(count > 0 ? count : 0), result_profile(result.size());
+        vector<char> done(result.size(), 0);
+        size_t printed = 0;
+        mutex m;
+        ThreadPool pool(min(jobs, count));
+        pool.run(count, [&](int i, int) {
+            ostringstream os, prof;
+            run_seed(first + i, cap, mode, os, profile ? &prof : nullptr, profile_json);
+            lock_guard<mutex> lk(m);
+            result[i] = os.str();
+            result_profile[i] = prof.str();
+            done[i] = 1;
+            // print whatever prefix of the range is now complete
+            for (; printed < done.size() && done[printed]; ++printed)
+            {
+                cout << result[printed] << flush;
+                if (profile)
+                    *profile << result_profile[printed];
+                string().swap(result[printed]);
+                string().swap(result_profile[printed]);
+            }
+        });
+        return 0;
+    }
+    unsigned int seed = (argc > 1) ? static_cast<unsigned int>(strtoul(argv[1], nullptr, 10)) : 0u;
+    const int NUM_MAX_TASKS = (argc > 2) ? atoi(argv[2]) : 20;
+    return run_seed(seed, NUM_MAX_TASKS, (argc > 3) ? argv[3] : "", cout, profile, profile_json);
+}
@@ -5,13 +5,22 @@
 #   exact         -- exact optimum by subset DP: the real upper bound
 #   verify_exact  -- independent verification of `exact` (see HANDOFF 3a)
 #   plan          -- heuristic offline planner: a LOWER bound only
+#   scale         -- one run at any map size / robot count / task cap (scale.sh)
+#   verify_fork   -- a run forked or restored mid-way ends where it would have
+#   verify_ratio  -- the SSE4.1/AVX2 ratio scans pick the scalar scan's cell
 set -euo pipefail
 cd "$(dirname "$0")"
-g++ -O2 -std=c++17 -w -I shim -o bench bench.cpp ../simulator.cpp ../schedular.cpp
+g++ -O2 -std=c++17 -pthread -w -I shim -o bench bench.cpp ../simulator.cpp ../schedular.cpp ../simulation.cpp
 echo "built: bench/bench"
+g++ -O2 -std=c++17 -pthread -w -I shim -o scale scale.cpp ../simulator.cpp ../schedular.cpp ../simulation.cpp
+echo "built: bench/scale"
 if [ "${1:-}" = "all" ]; then
   for t in exact verify_exact plan; do
-    g++ -O2 -std=c++17 -w -I shim -o "$t" "$t.cpp" ../simulator.cpp
+    g++ -O2 -std=c++17 -pthread -w -I shim -o "$t" "$t.cpp" ../simulator.cpp
     echo "built: bench/$t"
   done
+  g++ -O2 -std=c++17 -pthread -w -I shim -o verify_fork verify_fork.cpp ../simulator.cpp ../schedular.cpp ../simulation.cpp
+  echo "built: bench/verify_fork"
+  g++ -O2 -std=c++17 -w -o verify_ratio verify_ratio.cpp
+  echo "built: bench/verify_ratio"
 fi
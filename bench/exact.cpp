@@ -21,48 +21,62 @@
 //      (energy spent, completion time) -- the two are not interchangeable
 //      because waiting for a release costs time but no energy.
 //   2. Partition the 16 tasks across the 4 workers to maximise the count, by
-//      subset-sum DP over all S and all T subset of S.
+//      DP over the unions of those subsets.
+// Both steps are the scheduler's own exact-plan kernel (../exact_plan.h), run
+// here on the full relaxed instance.  SCHED_T_THREADS=<n> spreads them over n
+// threads; the answer does not depend on it.
 //
-// Usage: ./exact <seed>
+// Usage: ./exact <seed> [nofore]
 // Output: seed,exact_optimum,num_tasks,unreachable
-#include "../../simulator.h"
+#include "../simulator.h"
+#include "../bucket_queue.h"
+#include "../exact_plan.h"
 #include <cstdlib>
-#include <queue>
 #include <algorithm>
 
 static const int INF = 1000000000;
 
-static vector<int> dijkstra(const vector<vector<vector<int>>> &cost, int n, Coord src, int type)
+static vector<int> dijkstra(const GRID<int> &cost, int n, Coord src, int type)
 {
     vector<int> d(n * n, INF);
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+    // every step is a multiple of 10 no larger than the dearest cell's step
+    int cmax = 0;
+    for (int i = 0; i < n * n; ++i)
+        if (cost.plane(type)[i] != INFINITE)
+            cmax = max(cmax, cost.plane(type)[i]);
+    BucketQueue pq;
+    vector<int> bucket;
+    pq.reset(((cmax / 2 + cmax) + 9) / 10 * 10, 10);
     int s = src.x * n + src.y;
     d[s] = 0;
-    pq.push(make_pair(0, s));
+    pq.push(0, s);
     static const int DX[4] = {0, 0, -1, 1}, DY[4] = {1, -1, 0, 0};
     while (!pq.empty())
     {
-        pair<int, int> t = pq.top();
-        pq.pop();
-        if (t.first != d[t.second])
-            continue;
-        int ux = t.second / n, uy = t.second % n;
-        int cu = cost[ux][uy][type];
-        if (cu == INFINITE || cu < 0)
-            continue;
-        for (int k = 0; k < 4; ++k)
+        int t = pq.pop_bucket(bucket);
+        for (size_t b = 0; b < bucket.size(); ++b)
         {
-            int vx = ux + DX[k], vy = uy + DY[k];
-            if (vx < 0 || vy < 0 || vx >= n || vy >= n)
+            int u = bucket[b];
+            if (t != d[u])
                 continue;
-            int cv = cost[vx][vy][type];
-            if (cv == INFINITE || cv < 0)
+            int ux = u / n, uy = u % n;
+            int cu = cost.at(ux, uy, type);
+            if (cu == INFINITE || cu < 0)
                 continue;
-            int w = ((cu / 2 + cv) + 9) / 10 * 10;
-            if (t.first + w < d[vx * n + vy])
+            for (int k = 0; k < 4; ++k)
             {
-                d[vx * n + vy] = t.first + w;
-                pq.push(make_pair(t.first + w, vx * n + vy));
+                int vx = ux + DX[k], vy = uy + DY[k];
+                if (vx < 0 || vy < 0 || vx >= n || vy >= n)
+                    continue;
+                int cv = cost.at(vx, vy, type);
+                if (cv == INFINITE || cv < 0)
+                    continue;
+                int w = ((cu / 2 + cv) + 9) / 10 * 10;
+                if (t + w < d[vx * n + vy])
+                {
+                    d[vx * n + vy] = t + w;
+                    pq.push(t + w, vx * n + vy);
+                }
             }
         }
     }
@@ -81,19 +95,16 @@ int main(int argc, char **argv)
     const int TIME_MAX = MAP_SIZE * 100;
     const int ROBOT_ENERGY = TIME_MAX * 6;
 
-    srand(seed);
-    MAP map(MAP_SIZE, NUM_ROBOT, NT / 2, NT, WALL_DENSITY, ROBOT_ENERGY);
+    MAP map(MAP_SIZE, NUM_ROBOT, NT / 2, NT, WALL_DENSITY, ROBOT_ENERGY, RNG(seed));
     TASKDISPATCHER disp(map, TIME_MAX);
     for (int t = 0; t < TIME_MAX; ++t)
         disp.try_dispatch(t);
     {
-        set<Coord> all;
-        for (int x = 0; x < MAP_SIZE; ++x)
-            for (int y = 0; y < MAP_SIZE; ++y)
-                all.emplace(x, y);
+        CELL_BITMAP all(MAP_SIZE);
+        all.fill();
         map.update_coords(all);
     }
-    const vector<vector<vector<int>>> &cost = map.get_known_cost_map();
+    const GRID<int> &cost = map.get_known_cost_map();
 
     vector<int> wtype;
     vector<Coord> wpos;
@@ -152,39 +163,21 @@ int main(int argc, char **argv)
             ++unreachable;
     }
 
-    const int FULL = 1 << nt;
-
-    // ---- step 1: which subsets can each worker serve, in some order? --------
-    // state (S, last) -> Pareto frontier of (energy spent, completion time)
-    vector<vector<char>> feas(NW, vector<char>(FULL, 0));
+    // ---- subset DP per worker, then the partition (../exact_plan.h) --------
+    vector<ExactPlanner::Worker> ew(NW);
     for (int w = 0; w < NW; ++w)
     {
         int ty = wtype[w];
-        vector<vector<pair<int, int>>> par(static_cast<size_t>(FULL) * nt);
-        vector<int> order;
-        for (int S = 1; S < FULL; ++S)
-            order.push_back(S);
-        sort(order.begin(), order.end(), [](int a, int b) {
-            return __builtin_popcount(a) < __builtin_popcount(b);
-        });
-
-        auto add = [&](size_t key, int e, int t) {
-            vector<pair<int, int>> &v = par[key];
-            for (size_t i = 0; i < v.size(); ++i)
-                if (v[i].first <= e && v[i].second <= t)
-                    return;
-            for (size_t i = 0; i < v.size();)
-            {
-                if (v[i].first >= e && v[i].second >= t)
-                    v.erase(v.begin() + i);
-                else
-                    ++i;
-            }
-            v.push_back(make_pair(e, t));
-        };
-
+        ew[w].energy = ROBOT_ENERGY;
+        ew[w].horizon = TIME_MAX;
+        ew[w].leg.resize(static_cast<size_t>(nt) * nt);
+        ew[w].work.resize(nt);
+        ew[w].first.assign(nt, make_pair(INF, 0));
         for (int j = 0; j < nt; ++j)
         {
+            ew[w].work[j] = work[j][ty];
+            for (int i = 0; i < nt; ++i)
+                ew[w].leg[i * nt + j] = (i == j) ? INF : dtt[ty][i][j];
             if (dstart[w][j] >= INF || work[j][ty] >= INF)
                 continue;
             int e = dstart[w][j] + work[j][ty];
@@ -195,74 +188,14 @@ int main(int argc, char **argv)
             int t = start + work[j][ty] / 10;
             if (t > TIME_MAX)
                 continue;
-            add(static_cast<size_t>(1 << j) * nt + j, e, t);
-            feas[w][1 << j] = 1;
-        }
-
-        for (size_t oi = 0; oi < order.size(); ++oi)
-        {
-            int S = order[oi];
-            for (int last = 0; last < nt; ++last)
-            {
-                if (!((S >> last) & 1))
-                    continue;
-                const vector<pair<int, int>> cur = par[static_cast<size_t>(S) * nt + last];
-                if (cur.empty())
-                    continue;
-                feas[w][S] = 1;
-                for (int j = 0; j < nt; ++j)
-                {
-                    if ((S >> j) & 1)
-                        continue;
-                    int leg = dtt[ty][last][j];
-                    if (leg >= INF || work[j][ty] >= INF)
-                        continue;
-                    for (size_t c = 0; c < cur.size(); ++c)
-                    {
-                        int e = cur[c].first + leg + work[j][ty];
-                        if (e > ROBOT_ENERGY)
-                            continue;
-                        int depart = cur[c].second;
-                        if (nofore && depart < release[j])
-                            depart = release[j];
-                        int start = max(depart + leg / 10, release[j]);
-                        int t = start + work[j][ty] / 10;
-                        if (t > TIME_MAX)
-                            continue;
-                        add(static_cast<size_t>(S | (1 << j)) * nt + j, e, t);
-                    }
-                }
-            }
-        }
-    }
-
-    // ---- step 2: partition the tasks across workers to maximise the count ---
-    vector<signed char> dp(FULL, -1), ndp(FULL, -1);
-    dp[0] = 0;
-    for (int w = 0; w < NW; ++w)
-    {
-        ndp = dp;
-        for (int S = 0; S < FULL; ++S)
-        {
-            if (dp[S] < 0)
-                continue;
-            int rest = (FULL - 1) & ~S;
-            // enumerate every subset T of the still-unused tasks
-            for (int T = rest; T; T = (T - 1) & rest)
-            {
-                if (!feas[w][T])
-                    continue;
-                int v = dp[S] + __builtin_popcount(T);
-                if (v > ndp[S | T])
-                    ndp[S | T] = static_cast<signed char>(v);
-            }
+            ew[w].first[j] = make_pair(e, t);
         }
-        dp.swap(ndp);
     }
-    int best = 0;
-    for (int S = 0; S < FULL; ++S)
-        if (dp[S] > best)
-            best = dp[S];
+    const char *threads = getenv("SCHED_T_THREADS");
+    ThreadPool pool(threads ? atoi(threads) : 1);
+    ExactPlanner exact;
+    exact.solve(nt, ew, release.data(), nofore, &pool);
+    int best = exact.count();
 
     cout << seed << "," << best << "," << nt << "," << unreachable << endl;
     return 0;
@@ -9,10 +9,9 @@ OUTDIR=${BENCH_OUT:-$(pwd)/out}
 mkdir -p "$OUTDIR"
 OUT=$OUTDIR/${LABEL}.csv
 if [ -n "$MODE" ]; then
-  seq "$START" $((START + N - 1)) | xargs -P "$(nproc)" -I{} ./bench {} "$CAP" "$MODE" 2>/dev/null \
-    | grep -E "^[0-9]+,${CAP}," > "$OUT"
+  ./bench --seeds "$START" "$N" "$CAP" "$MODE" 2>/dev/null | grep -E "^[0-9]+,${CAP}," > "$OUT"
 else
-  seq "$START" $((START + N - 1)) | xargs -P "$(nproc)" -I{} ./bench {} "$CAP" > "$OUT"
+  ./bench --seeds "$START" "$N" "$CAP" > "$OUT"
 fi
 echo "--- $LABEL (seeds $START..$((START+N-1)) cap=$CAP ${MODE}) ---"
 python3 - "$OUT" <<'PY'
@@ -19,47 +19,57 @@
 //
 // Usage: ./plan <seed> [restarts=300] [notime]
 // Output: seed,best_completed,greedy_completed,energy_used
-#include "../../simulator.h"
+#include "../simulator.h"
+#include "../bucket_queue.h"
 #include <cstdlib>
 #include <climits>
-#include <queue>
 #include <algorithm>
 
 static const int INF = 1000000000;
 
 int MAPN = 20;
 
-static vector<int> dijkstra(const vector<vector<vector<int>>> &cost, int n, Coord src, int type)
+static vector<int> dijkstra(const GRID<int> &cost, int n, Coord src, int type)
 {
     vector<int> d(n * n, INF);
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+    // every step is a multiple of 10 no larger than the dearest cell's step
+    int cmax = 0;
+    for (int i = 0; i < n * n; ++i)
+        if (cost.plane(type)[i] != INFINITE)
+            cmax = max(cmax, cost.plane(type)[i]);
+    BucketQueue pq;
+    vector<int> bucket;
+    pq.reset(((cmax / 2 + cmax) + 9) / 10 * 10, 10);
     int s = src.x * n + src.y;
     d[s] = 0;
-    pq.push(make_pair(0, s));
+    pq.push(0, s);
     static const int DX[4] = {0, 0, -1, 1}, DY[4] = {1, -1, 0, 0};
     while (!pq.empty())
     {
-        pair<int, int> t = pq.top();
-        pq.pop();
-        if (t.first != d[t.second])
-            continue;
-        int ux = t.second / n, uy = t.second % n;
-        int cu = cost[ux][uy][type];
-        if (cu == INFINITE || cu < 0)
-            continue;
-        for (int k = 0; k < 4; ++k)
+        int t = pq.pop_bucket(bucket);
+        for (size_t b = 0; b < bucket.size(); ++b)
         {
-            int vx = ux + DX[k], vy = uy + DY[k];
-            if (vx < 0 || vy < 0 || vx >= n || vy >= n)
+            int u = bucket[b];
+            if (t != d[u])
                 continue;
-            int cv = cost[vx][vy][type];
-            if (cv == INFINITE || cv < 0)
+            int ux = u / n, uy = u % n;
+            int cu = cost.at(ux, uy, type);
+            if (cu == INFINITE || cu < 0)
                 continue;
-            int w = ((cu / 2 + cv) + 9) / 10 * 10;
-            if (t.first + w < d[vx * n + vy])
+            for (int k = 0; k < 4; ++k)
             {
-                d[vx * n + vy] = t.first + w;
-                pq.push(make_pair(t.first + w, vx * n + vy));
+                int vx = ux + DX[k], vy = uy + DY[k];
+                if (vx < 0 || vy < 0 || vx >= n || vy >= n)
+                    continue;
+                int cv = cost.at(vx, vy, type);
+                if (cv == INFINITE || cv < 0)
+                    continue;
+                int w = ((cu / 2 + cv) + 9) / 10 * 10;
+                if (t + w < d[vx * n + vy])
+                {
+                    d[vx * n + vy] = t + w;
+                    pq.push(t + w, vx * n + vy);
+                }
             }
         }
     }
@@ -131,20 +141,17 @@ int main(int argc, char **argv)
     const int ROBOT_ENERGY = TIME_MAX * 6;
     MAPN = MAP_SIZE;
 
-    srand(seed);
-    MAP map(MAP_SIZE, NUM_ROBOT, NUM_MAX_TASKS / 2, NUM_MAX_TASKS, WALL_DENSITY, ROBOT_ENERGY);
+    MAP map(MAP_SIZE, NUM_ROBOT, NUM_MAX_TASKS / 2, NUM_MAX_TASKS, WALL_DENSITY, ROBOT_ENERGY, RNG(seed));
     TASKDISPATCHER disp(map, TIME_MAX);
     // robots never move, so the spawn positions depend only on the seed
     for (int t = 0; t < TIME_MAX; ++t)
         disp.try_dispatch(t);
     {
-        set<Coord> all;
-        for (int x = 0; x < MAP_SIZE; ++x)
-            for (int y = 0; y < MAP_SIZE; ++y)
-                all.emplace(x, y);
+        CELL_BITMAP all(MAP_SIZE);
+        all.fill();
         map.update_coords(all);
     }
-    const vector<vector<vector<int>>> &cost = map.get_known_cost_map();
+    const GRID<int> &cost = map.get_known_cost_map();
 
     Inst in;
     in.horizon = notime ? 1000000 : TIME_MAX;
@@ -196,6 +203,8 @@ int main(int argc, char **argv)
         }
 
     // ---- search: randomized cheapest insertion + local search ---------------
+    // the randomisation continues the instance's own stream
+    RNG &rng = map.get_rng();
     vector<vector<int>> best;
     int best_n = -1, greedy_n = -1;
     vector<vector<int>> cur(in.nw);
@@ -234,7 +243,7 @@ int main(int argc, char **argv)
                         eval_seq(in, w, t, &e1);
                         long long c = (e1 - e0);
                         if (rs > 0)
-                            c = c * (90 + rand() % 25) / 100;
+                            c = c * (90 + rng() % 25) / 100;
                         if (bcost < 0 || c < bcost)
                         {
                             bcost = c;
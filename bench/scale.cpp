@@ -0,0 +1,67 @@
+// Scaling probe: one SIMULATION at an arbitrary map size, robot count and
+// task cap, timed tick by tick.  Prints a single CSV line:
+//
+//   map,robots,tasks,seed,ticks,created,discovered,completed,exhausted,
+//   mean_us,p50_us,p99_us,max_us,sched_s,wall_s,peak_rss_kb
+//
+// where the latencies are the scheduler's time per tick (every callback of
+// the tick together), sched_s its total, wall_s the whole run including the
+// simulator, and peak_rss_kb the process's peak resident set.  One point per
+// process, so the RSS is that point's alone; scale.sh sweeps the grid.
+//
+// Usage: ./scale <map_size> <num_robot> <num_max_tasks> [seed=1]
+//   SCALE_TICKS=<n>     stop after n ticks (default: the full run,
+//                       map_size * 100 ticks)
+//   SCALE_BUDGET_S=<s>  stop once the run has taken s seconds of wall time
+// A run cut short still reports the ticks it did; per-tick numbers stay
+// comparable, the outcome columns do not.
+#include "../simulator.h"
+#include "../schedular.h"
+#include "../simulation.h"
+#include <cstdlib>
+#include <sys/resource.h>
+
+static long peak_rss_kb()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss; // kilobytes on Linux
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        cerr << "usage: " << argv[0] << " <map_size> <num_robot> <num_max_tasks> [seed=1]" << endl;
+        return 2;
+    }
+    SIMULATION::CONFIG config;
+    config.map_size = atoi(argv[1]);
+    config.num_robot = atoi(argv[2]);
+    config.num_max_tasks = atoi(argv[3]);
+    const unsigned int seed = (argc > 4) ? static_cast<unsigned int>(strtoul(argv[4], nullptr, 10)) : 1u;
+    config.rng = RNG(seed);
+    const int max_ticks = getenv("SCALE_TICKS") ? atoi(getenv("SCALE_TICKS")) : -1;
+    const double budget_s = getenv("SCALE_BUDGET_S") ? atof(getenv("SCALE_BUDGET_S")) : 0.0;
+
+    const chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    SIMULATION sim(config);
+    int ticks = 0;
+    for (; max_ticks < 0 || ticks < max_ticks; ++ticks)
+    {
+        if (budget_s > 0 && chrono::duration<double>(chrono::steady_clock::now() - t0).count() >= budget_s)
+            break;
+        if (!sim.step())
+            break;
+    }
+    const double wall_s = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    const SIMULATION::RESULT res = sim.result();
+    const LatencyHistogram &lat = res.tick_latency;
+
+    cout << config.map_size << "," << config.num_robot << "," << config.num_max_tasks << "," << seed << ","
+         << ticks << "," << res.created << "," << res.discovered << "," << res.completed << "," << res.exhausted
+         << "," << static_cast<long long>(lat.mean() / 1000) << "," << lat.percentile(0.50) / 1000 << ","
+         << lat.percentile(0.99) / 1000 << "," << lat.max() / 1000 << ","
+         << chrono::duration<double>(res.scheduler_time).count() << "," << wall_s << "," << peak_rss_kb() << endl;
+    return 0;
+}
@@ -0,0 +1,48 @@
+#!/usr/bin/env bash
+# Scaling sweep of the scheduler: map size, robot count and task cap, one at a
+# time from a base point, then all three together.  Every point is a separate
+# ./scale process (so peak RSS is per point) with its tick count and wall time
+# capped; the per-tick latency columns are what the curves are read from.
+# Usage: ./scale.sh [seed=1]
+#   SCALE_TICKS     ticks per point (default 200)
+#   SCALE_BUDGET_S  wall seconds per point (default 120)
+# Writes $BENCH_OUT/scale.csv (default bench/out, git-ignored) -- the plot
+# data, with a `sweep` column first -- then prints it as a table with the
+# log-log slope of mean tick time against each swept variable.
+set -euo pipefail
+cd "$(dirname "$0")"
+SEED=${1:-1}
+export SCALE_TICKS=${SCALE_TICKS:-200}
+export SCALE_BUDGET_S=${SCALE_BUDGET_S:-120}
+OUTDIR=${BENCH_OUT:-$(pwd)/out}
+mkdir -p "$OUTDIR"
+OUT=$OUTDIR/scale.csv
+[ -x ./scale ] || g++ -O2 -std=c++17 -pthread -w -I shim -o scale scale.cpp ../simulator.cpp ../schedular.cpp ../simulation.cpp
+
+echo "sweep,map,robots,tasks,seed,ticks,created,discovered,completed,exhausted,mean_us,p50_us,p99_us,max_us,sched_s,wall_s,peak_rss_kb" > "$OUT"
+point() { echo "$1,$(./scale "$2" "$3" "$4" "$SEED")" | tee -a "$OUT" >&2; }
+for m in 20 50 100 200 500; do point map "$m" 6 16; done
+for r in 6 12 24 48 96 300; do point robots 100 "$r" 16; done
+for t in 16 64 250 1000 2000; do point tasks 100 6 "$t"; done
+for s in "20 6 16" "50 15 40" "100 30 100" "200 60 400" "500 300 2000"; do point all $s; done
+
+python3 - "$OUT" <<'PY'
+import sys, csv, math
+rows = list(csv.DictReader(open(sys.argv[1])))
+cols = ["sweep", "map", "robots", "tasks", "ticks", "completed", "mean_us", "p99_us", "max_us", "peak_rss_kb"]
+w = {c: max(len(c), *(len(r[c]) for r in rows)) for c in cols}
+print("  ".join(c.rjust(w[c]) for c in cols))
+for r in rows:
+    print("  ".join(r[c].rjust(w[c]) for c in cols))
+axis = {"map": "map", "robots": "robots", "tasks": "tasks", "all": "map"}
+for sweep, x in axis.items():
+    pts = [(float(r[x]), float(r["mean_us"])) for r in rows if r["sweep"] == sweep and float(r["mean_us"]) > 0]
+    if len(pts) < 2:
+        continue
+    lx = [math.log(a) for a, _ in pts]
+    ly = [math.log(b) for _, b in pts]
+    mx, my = sum(lx) / len(lx), sum(ly) / len(ly)
+    sxx = sum((a - mx) ** 2 for a in lx)
+    k = sum((a - mx) * (b - my) for a, b in zip(lx, ly)) / sxx if sxx else 0.0
+    print(f"mean tick time ~ {x}^{k:.2f}  (sweep '{sweep}')")
+PY
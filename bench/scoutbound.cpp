@@ -45,8 +45,9 @@
 // Usage:  ./scoutbound <seed> [iters=60000]
 // Output: SCOUT,seed,disc_actual,V_actual,V_workers,V_greedy,V_opt,V_opt_fixpace,
 //                drone_steps,step_ticks,n_open
-#include "../../simulator.h"
-#include "../../schedular.h"
+#include "../simulator.h"
+#include "../schedular.h"
+#include "../simulation.h"
 #include <cstdlib>
 #include <climits>
 #include <queue>
@@ -284,16 +285,19 @@ int main(int argc, char **argv)
     const int WALL_DENSITY = 20;
     const int ROBOT_ENERGY = TMAX * 6;
 
-    srand(seed);
-    MAP map(MSZ, 6, NUM_INITIAL_TASKS, NUM_MAX_TASKS, WALL_DENSITY, ROBOT_ENERGY);
-    int time = -1;
+    SIMULATION::CONFIG config;
+    config.map_size = MSZ;
+    config.num_robot = 6;
+    config.num_max_tasks = NUM_MAX_TASKS;
+    config.num_initial_tasks = NUM_INITIAL_TASKS;
+    config.wall_density = WALL_DENSITY;
+    config.time_max = TMAX;
+    config.robot_energy = ROBOT_ENERGY;
+    config.rng = RNG(seed);
+    SIMULATION sim(config);
+    MAP &map = sim.map();
     auto &robots = map.get_robots();
-    auto &known_cost_map = map.get_known_cost_map();
-    auto &known_object_map = map.get_known_object_map();
     auto &active_tasks = map.get_active_tasks();
-    Scheduler scheduler;
-    TASKDISPATCHER taskdispatcher(map, TMAX);
-    set<Coord> observed_coords, updated_coords;
 
     // per-tick observation record, split drone / worker
     vector<int> L_all(NC, -1), L_work(NC, -1);
@@ -311,93 +315,52 @@ int main(int argc, char **argv)
     }
     vector<Coord> prev_drone_pos(2, Coord(-1, -1));
 
-    while (++time < TMAX &&
-           robots.size() != map.get_exhausted_robot_num() &&
-           map.num_total_task != map.get_completed_task_num())
-    {
-        taskdispatcher.try_dispatch(time);
-        observed_coords = map.observed_coord_by_robot();
-
+    sim.hooks.after_observe = [&](SIMULATION &) {
         // record the same windows observed_coord_by_robot() builds, but keeping
         // track of which robot class produced each one
+        int di = 0;
+        for (auto &r : robots)
         {
-            int di = 0;
-            for (auto &r : robots)
+            if (r->get_status() == ROBOT::STATUS::EXHAUSTED)
             {
-                if (r->get_status() == ROBOT::STATUS::EXHAUSTED)
-                {
-                    if (r->type == ROBOT::TYPE::DRONE)
-                        ++di;
-                    continue;
-                }
-                int vr = ROBOT::view_range_list[static_cast<size_t>(r->type)];
-                bool cross = (ROBOT::view_type_list[static_cast<size_t>(r->type)] ==
-                              ROBOT::VIEWTYPE::CROSS);
-                int x = r->get_coord().x, y = r->get_coord().y;
-                bool is_drone = (r->type == ROBOT::TYPE::DRONE);
-                for (int xx = max(x - vr, 0); xx <= min(x + vr, MSZ - 1); ++xx)
-                    for (int yy = max(y - vr, 0); yy <= min(y + vr, MSZ - 1); ++yy)
-                    {
-                        if (cross && xx != x && yy != y)
-                            continue;
-                        int c = xx * MSZ + yy;
-                        if (L_all[c] < time)
-                            L_all[c] = time;
-                        if (!is_drone && L_work[c] < time)
-                            L_work[c] = time;
-                    }
-                if (is_drone && di < 2)
-                {
-                    if (!(prev_drone_pos[di] == r->get_coord()) && prev_drone_pos[di].x >= 0)
-                        ++drone_steps_actual;
-                    prev_drone_pos[di] = r->get_coord();
+                if (r->type == ROBOT::TYPE::DRONE)
                     ++di;
-                }
+                continue;
             }
-        }
-
-        updated_coords = map.update_coords(observed_coords);
-        scheduler.on_info_updated(observed_coords, updated_coords, known_cost_map,
-                                  known_object_map, active_tasks, robots);
-        for (auto robot : robots)
-        {
-            auto &status = robot->get_status();
-            if (status == ROBOT::STATUS::IDLE)
-            {
-                auto coord = robot->get_coord();
-                bool do_task = false;
-                weak_ptr<TASK> task;
-                if (bool(known_object_map[coord.x][coord.y] & OBJECT::TASK))
+            int vr = ROBOT::view_range_list[static_cast<size_t>(r->type)];
+            bool cross = (ROBOT::view_type_list[static_cast<size_t>(r->type)] ==
+                          ROBOT::VIEWTYPE::CROSS);
+            int x = r->get_coord().x, y = r->get_coord().y;
+            bool is_drone = (r->type == ROBOT::TYPE::DRONE);
+            for (int xx = max(x - vr, 0); xx <= min(x + vr, MSZ - 1); ++xx)
+                for (int yy = max(y - vr, 0); yy <= min(y + vr, MSZ - 1); ++yy)
                 {
-                    task = map.task_at(coord);
-                    do_task = scheduler.on_task_reached(observed_coords, updated_coords,
-                                                        known_cost_map, known_object_map,
-                                                        active_tasks, robots, *robot,
-                                                        *(task.lock()));
+                    if (cross && xx != x && yy != y)
+                        continue;
+                    int c = xx * MSZ + yy;
+                    if (L_all[c] < sim.time())
+                        L_all[c] = sim.time();
+                    if (!is_drone && L_work[c] < sim.time())
+                        L_work[c] = sim.time();
                 }
-                if (do_task)
-                    robot->start_working(task);
-                else
-                    robot->start_moving(scheduler.idle_action(observed_coords, updated_coords,
-                                                              known_cost_map, known_object_map,
-                                                              active_tasks, robots, *robot));
+            if (is_drone && di < 2)
+            {
+                if (!(prev_drone_pos[di] == r->get_coord()) && prev_drone_pos[di].x >= 0)
+                    ++drone_steps_actual;
+                prev_drone_pos[di] = r->get_coord();
+                ++di;
             }
-            if (status == ROBOT::STATUS::MOVING)
-                robot->move();
-            else if (status == ROBOT::STATUS::WORKING)
-                robot->work();
         }
-    }
+    };
+    sim.run();
 
     int completed = map.get_completed_task_num();
     int discovered = completed + static_cast<int>(active_tasks.size());
 
     // ---- reveal the true map and set the problem up ----------------------
     {
-        set<Coord> all;
-        for (int x = 0; x < MSZ; ++x)
-            for (int y = 0; y < MSZ; ++y)
-                all.emplace(x, y);
+        CELL_BITMAP all(MSZ);
+        all.fill();
         map.update_coords(all);
     }
     Prob P;
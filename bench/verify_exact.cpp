@@ -25,8 +25,8 @@
 // Usage: ./verify_exact <seed> [max_subset_size=6]
 // Output: one line per check, plus "VERIFY <seed> OK" / "... FAIL".
 #include "../simulator.h"
+#include "../bucket_queue.h"
 #include <cstdlib>
-#include <queue>
 #include <algorithm>
 
 static const int INF = 1000000000;
@@ -35,40 +35,50 @@ static const int TIME_MAX = MAP_SIZE * 100;
 static const int ROBOT_ENERGY = TIME_MAX * 6;
 
 // Dijkstra that also records a parent, so a concrete path can be replayed.
-static void dijkstra(const vector<vector<vector<int>>> &cost, int n, Coord src, int type,
+static void dijkstra(const GRID<int> &cost, int n, Coord src, int type,
                      vector<int> &d, vector<int> &par)
 {
     d.assign(n * n, INF);
     par.assign(n * n, -1);
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+    // every step is a multiple of 10 no larger than the dearest cell's step
+    int cmax = 0;
+    for (int i = 0; i < n * n; ++i)
+        if (cost.plane(type)[i] != INFINITE)
+            cmax = max(cmax, cost.plane(type)[i]);
+    BucketQueue pq;
+    vector<int> bucket;
+    pq.reset(((cmax / 2 + cmax) + 9) / 10 * 10, 10);
     int s = src.x * n + src.y;
     d[s] = 0;
-    pq.push(make_pair(0, s));
+    pq.push(0, s);
     static const int DX[4] = {0, 0, -1, 1}, DY[4] = {1, -1, 0, 0};
     while (!pq.empty())
     {
-        pair<int, int> t = pq.top();
-        pq.pop();
-        if (t.first != d[t.second])
-            continue;
-        int ux = t.second / n, uy = t.second % n;
-        int cu = cost[ux][uy][type];
-        if (cu == INFINITE || cu < 0)
-            continue;
-        for (int k = 0; k < 4; ++k)
+        int t = pq.pop_bucket(bucket);
+        for (size_t b = 0; b < bucket.size(); ++b)
         {
-            int vx = ux + DX[k], vy = uy + DY[k];
-            if (vx < 0 || vy < 0 || vx >= n || vy >= n)
+            int u = bucket[b];
+            if (t != d[u])
                 continue;
-            int cv = cost[vx][vy][type];
-            if (cv == INFINITE || cv < 0)
+            int ux = u / n, uy = u % n;
+            int cu = cost.at(ux, uy, type);
+            if (cu == INFINITE || cu < 0)
                 continue;
-            int w = ((cu / 2 + cv) + 9) / 10 * 10;
-            if (t.first + w < d[vx * n + vy])
+            for (int k = 0; k < 4; ++k)
             {
-                d[vx * n + vy] = t.first + w;
-                par[vx * n + vy] = t.second;
-                pq.push(make_pair(t.first + w, vx * n + vy));
+                int vx = ux + DX[k], vy = uy + DY[k];
+                if (vx < 0 || vy < 0 || vx >= n || vy >= n)
+                    continue;
+                int cv = cost.at(vx, vy, type);
+                if (cv == INFINITE || cv < 0)
+                    continue;
+                int w = ((cu / 2 + cv) + 9) / 10 * 10;
+                if (t + w < d[vx * n + vy])
+                {
+                    d[vx * n + vy] = t + w;
+                    par[vx * n + vy] = u;
+                    pq.push(t + w, vx * n + vy);
+                }
             }
         }
     }
@@ -91,17 +101,14 @@ struct Inst
 // Build the instance exactly the way exact.cpp does.
 static void build(unsigned seed, Inst &in, MAP **out_map)
 {
-    srand(seed);
-    MAP *map = new MAP(MAP_SIZE, NUM_ROBOT, NT / 2, NT, WALL_DENSITY, ROBOT_ENERGY);
+    MAP *map = new MAP(MAP_SIZE, NUM_ROBOT, NT / 2, NT, WALL_DENSITY, ROBOT_ENERGY, RNG(seed));
     TASKDISPATCHER disp(*map, TIME_MAX);
     for (int t = 0; t < TIME_MAX; ++t)
         disp.try_dispatch(t);
-    set<Coord> all;
-    for (int x = 0; x < MAP_SIZE; ++x)
-        for (int y = 0; y < MAP_SIZE; ++y)
-            all.emplace(x, y);
+    CELL_BITMAP all(MAP_SIZE);
+    all.fill();
     map->update_coords(all);
-    const vector<vector<vector<int>>> &cost = map->get_known_cost_map();
+    const GRID<int> &cost = map->get_known_cost_map();
 
     int rid = 0;
     for (auto &r : map->get_robots())
@@ -426,20 +433,17 @@ int main(int argc, char **argv)
             continue;
 
         // --- now execute exactly that route in a fresh, real simulation ---
-        srand(seed);
-        MAP m2(MAP_SIZE, NUM_ROBOT, NT / 2, NT, WALL_DENSITY, ROBOT_ENERGY);
+        MAP m2(MAP_SIZE, NUM_ROBOT, NT / 2, NT, WALL_DENSITY, ROBOT_ENERGY, RNG(seed));
         TASKDISPATCHER d2(m2, TIME_MAX);
         auto &robots = m2.get_robots();
         auto &kom = m2.get_known_object_map();
         // reveal everything so the replay can path freely
         {
-            set<Coord> all;
-            for (int x = 0; x < MAP_SIZE; ++x)
-                for (int y = 0; y < MAP_SIZE; ++y)
-                    all.emplace(x, y);
+            CELL_BITMAP all(MAP_SIZE);
+            all.fill();
             m2.update_coords(all);
         }
-        const vector<vector<vector<int>>> &cm = m2.get_known_cost_map();
+        const GRID<int> &cm = m2.get_known_cost_map();
         auto robot = robots[in.wid[w]];
         size_t leg_i = 0;
         vector<int> path; // cells still to walk for the current leg
@@ -0,0 +1,82 @@
+// Verification of SIMULATION::fork / snapshot / restore.
+//
+// A snapshot carries the Scheduler along with the world, so a run picked up
+// from one must end exactly where the uninterrupted run does.  For each cut
+// tick T (before the first tick, and a few points through the run) this runs
+// the seed once straight through, then checks two ways of continuing from T
+// against it:
+//
+//   fork     step to T, fork, run the fork to the end; the original, run on
+//            to the end after it, must not have been disturbed either.
+//   restore  step to T, snapshot, run to the end, restore the snapshot and
+//            run to the end again.
+//
+// Results are compared on every outcome column (created, discovered,
+// completed, exhausted, end tick, energies left).  The scheduler must be
+// deterministic for this, which it is unless SCHED_T_DEADLINE is set.
+//
+// Usage: ./verify_fork <seed> [num_max_tasks=20]
+// Output: one line per check, plus "VERIFY_FORK <seed> OK" / "... FAIL".
+#include "../simulator.h"
+#include "../schedular.h"
+#include "../simulation.h"
+#include <cstdlib>
+
+static string outcome(const SIMULATION::RESULT &r)
+{
+    return to_string(r.created) + "," + to_string(r.discovered) + "," + to_string(r.completed) + "," +
+           to_string(r.exhausted) + "," + to_string(r.end_time) + "," + to_string(r.worker_energy) + "," +
+           to_string(r.drone_energy);
+}
+
+// Steps `sim` until its clock reads `tick` (-1: not started).
+static void step_to(SIMULATION &sim, int tick)
+{
+    while (sim.time() < tick && sim.step())
+        ;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        cerr << "usage: " << argv[0] << " <seed> [num_max_tasks=20]" << endl;
+        return 2;
+    }
+    const unsigned int seed = static_cast<unsigned int>(strtoul(argv[1], nullptr, 10));
+    SIMULATION::CONFIG config;
+    config.num_max_tasks = (argc > 2) ? atoi(argv[2]) : 20;
+    config.rng = RNG(seed);
+
+    SIMULATION straight(config);
+    const string want = outcome(straight.run());
+    cout << "straight " << want << endl;
+    const int time_max = straight.config().time_max;
+
+    bool ok = true;
+    const int cuts[] = {-1, 0, time_max / 8, time_max / 4, time_max / 2, time_max * 3 / 4};
+    for (int cut : cuts)
+    {
+        SIMULATION sim(config);
+        step_to(sim, cut);
+        unique_ptr<SIMULATION> forked = sim.fork();
+        const string f = outcome(forked->run());
+        const string o = outcome(sim.run());
+        bool good = f == want && o == want;
+        cout << "fork@" << cut << " " << f << " original " << o << " " << (good ? "ok" : "MISMATCH") << endl;
+        ok = ok && good;
+
+        SIMULATION again(config);
+        step_to(again, cut);
+        const SIMULATION::SNAPSHOT snap = again.snapshot();
+        const string first = outcome(again.run());
+        again.restore(snap);
+        const string second = outcome(again.run());
+        good = first == want && second == want;
+        cout << "restore@" << cut << " " << second << " " << (good ? "ok" : "MISMATCH") << endl;
+        ok = ok && good;
+    }
+
+    cout << "VERIFY_FORK " << seed << " " << (ok ? "OK" : "FAIL") << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+// Verification of ratio_argmax.h: the SSE4.1 and AVX2 scans against the
+// scalar loop they replace.
+//
+// Every case is a random run of cells with its own cutoff, offset, skip and
+// running best, drawn so that the awkward inputs come up often: ties (gains
+// and distances from a handful of values), gains <= 0, cells past max_d, the
+// skipped cell, denominators d + k <= 0 (which would be an infinite or NaN
+// ratio in the vector paths), runs shorter than a vector and tails of every
+// length.  For each case every path the CPU has must leave the same
+// (best, at) as scan_scalar, and so must the dispatching scan().
+//
+// Usage: ./verify_ratio [cases=200000] [seed=1]
+// Output: the paths checked, the first few mismatches, and
+//         "VERIFY_RATIO OK" / "... FAIL".
+#include "../ratio_argmax.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    const long cases = (argc > 1) ? atol(argv[1]) : 200000;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(strtoul(argv[2], nullptr, 10)) : 1u;
+    std::mt19937 rng(seed);
+    auto pick = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+
+#ifdef RATIO_ARGMAX_X86
+    const int lvl = RatioArgmax::supported();
+#else
+    const int lvl = 0;
+#endif
+    printf("paths: scalar%s%s, dispatched level %d\n", lvl >= 1 ? " sse4.1" : "", lvl >= 2 ? " avx2" : "",
+#ifdef RATIO_ARGMAX_X86
+           RatioArgmax::level()
+#else
+           0
+#endif
+    );
+
+    std::vector<int> g, d;
+    long bad = 0;
+    for (long c = 0; c < cases; ++c)
+    {
+        const int count = pick(0, 1) ? pick(0, 9) : pick(10, 200);
+        // narrow ranges make equal ratios common; wide ones exercise rounding
+        const bool narrow = pick(0, 1) != 0;
+        const int k = pick(0, 7) == 0 ? pick(-60, 0) : pick(1, 600);
+        g.resize(count);
+        d.resize(count);
+        for (int i = 0; i < count; ++i)
+        {
+            g[i] = narrow ? pick(-1, 4) * 100 : pick(-5, 2000000);
+            d[i] = narrow ? pick(0, 5) * 10 : pick(0, 20000);
+        }
+        const int max_d = pick(0, 3) == 0 ? pick(0, 30) : (narrow ? 40 : pick(0, 20000));
+        const int skip = count > 0 && pick(0, 1) ? pick(0, count - 1) : -1;
+        const int best0 = pick(0, 2) == 0 ? pick(0, 3000) : -1;
+        const int at0 = best0 < 0 ? -1 : pick(0, 5);
+
+        int want = best0, want_at = at0;
+        RatioArgmax::scan_scalar(g.data(), d.data(), count, max_d, k, skip, want, want_at);
+        auto check = [&](const char *name, void (*fn)(const int *, const int *, int, int, int, int, int &, int &)) {
+            int best = best0, at = at0;
+            fn(g.data(), d.data(), count, max_d, k, skip, best, at);
+            if ((best != want || at != want_at) && ++bad <= 5)
+                printf("MISMATCH %s case %ld: count=%d k=%d max_d=%d skip=%d: (%d, %d), scalar (%d, %d)\n", name, c,
+                       count, k, max_d, skip, best, at, want, want_at);
+        };
+#ifdef RATIO_ARGMAX_X86
+        if (lvl >= 1)
+            check("sse4.1", RatioArgmax::scan_sse41);
+        if (lvl >= 2)
+            check("avx2", RatioArgmax::scan_avx2);
+#endif
+        check("scan", RatioArgmax::scan);
+    }
+    printf("%ld cases, %ld mismatches\n", cases, bad);
+    printf("VERIFY_RATIO %s\n", bad ? "FAIL" : "OK");
+    return bad ? 1 : 0;
+}
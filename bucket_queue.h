@@ -0,0 +1,60 @@
+#ifndef BUCKET_QUEUE_H_
+#define BUCKET_QUEUE_H_
+
+#include <algorithm>
+#include <vector>
+
+// Monotone bucket queue (Dial's algorithm) for shortest-path searches on the
+// map.  Every step weight is a small positive multiple of `quantum` bounded by
+// `max_step`, so every key still queued lies within max_step of the last one
+// popped, and a ring of max_step / quantum + 1 buckets holds them all.  A search
+// is then O(V + max key / quantum) instead of O(V log V).
+//
+// Buckets are handed out whole and sorted by node, so a search settles nodes in
+// (key, node) order -- the same order a priority_queue<pair<int, int>> pops
+// them in, which the scheduler's tie-breaks depend on.  Like that queue it uses
+// lazy deletion: an entry whose key no longer matches the node's distance is
+// stale and the caller skips it.
+class BucketQueue
+{
+public:
+    void reset(int max_step, int quantum = 1)
+    {
+        q = quantum;
+        num_buckets = max_step / quantum + 1;
+        if (static_cast<int>(buckets.size()) < num_buckets)
+            buckets.resize(num_buckets);
+        for (int i = 0; i < num_buckets; ++i)
+            buckets[i].clear();
+        cur = 0;
+        count = 0;
+    }
+    void push(int key, int node)
+    {
+        buckets[(key / q) % num_buckets].push_back(node);
+        ++count;
+    }
+    bool empty() const { return count == 0; }
+    // Moves the lowest non-empty bucket into `out`, sorted by node, and
+    // returns its key.
+    int pop_bucket(std::vector<int> &out)
+    {
+        while (buckets[cur % num_buckets].empty())
+            ++cur;
+        std::vector<int> &b = buckets[cur % num_buckets];
+        out.swap(b);
+        b.clear();
+        count -= out.size();
+        std::sort(out.begin(), out.end());
+        return static_cast<int>(cur * q);
+    }
+
+private:
+    std::vector<std::vector<int>> buckets;
+    int num_buckets = 1;
+    int q = 1;
+    long long cur = 0; // absolute bucket number (key / quantum) being drained
+    size_t count = 0;
+};
+
+#endif // BUCKET_QUEUE_H_
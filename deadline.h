@@ -0,0 +1,27 @@
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+#include <chrono>
+
+// Wall-clock cutoff for anytime work: planning phases poll passed() and stop
+// improving once it is true, keeping the best answer they have so far.  A
+// deadline built with a budget of 0 (or default-constructed) never expires,
+// and then passed() does not even read the clock.
+class Deadline
+{
+public:
+    Deadline() {}
+    explicit Deadline(long long budget_us)
+        : armed(budget_us > 0),
+          end(std::chrono::steady_clock::now() + std::chrono::microseconds(budget_us))
+    {
+    }
+    bool enabled() const { return armed; }
+    bool passed() const { return armed && std::chrono::steady_clock::now() >= end; }
+
+private:
+    bool armed = false;
+    std::chrono::steady_clock::time_point end;
+};
+
+#endif // DEADLINE_H_
@@ -0,0 +1,365 @@
+#ifndef EXACT_PLAN_H_
+#define EXACT_PLAN_H_
+
+#include "deadline.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Exact task-to-worker plan by subset DP, shared by the scheduler (over the
+// free tasks it knows of) and bench/exact.cpp (over the whole instance).
+//
+//   1. For each worker, a DP over (subset, last visited) carrying the Pareto
+//      frontier of (energy spent, finish tick) -- the two are not
+//      interchangeable, because waiting for a release costs time but no
+//      energy.  It runs layer by layer over subset size and keeps only the
+//      states that are reachable, each frontier a sorted run in one flat
+//      arena; what comes out is every subset the worker can serve in some
+//      order, with the least energy that takes, as a sorted list.
+//   2. A partition of the tasks across the workers that maximises the count
+//      and breaks ties on total energy.  It walks those lists worker by worker
+//      and keeps, for every union reached, the first best way there and the
+//      subset the worker took to get there, so the plan is rebuilt by walking
+//      back from the best union.
+//
+// Both phases can run on a ThreadPool: the workers' DPs are independent, and
+// the partition splits each worker's step into chunks of the reached unions,
+// each deduplicated on its own and then merged in chunk order.  Every union
+// keeps the first of its best candidates either way, so the result is the
+// same for any number of threads.
+//
+// Either phase gives up once an armed Deadline passes; solve() then reports
+// false and leaves no plan.
+class ExactPlanner
+{
+public:
+    static const int INF = 1000000000;
+    typedef std::pair<int, int> SubsetE; // (subset, least energy to serve exactly it)
+
+    // One worker's view of an instance of n tasks.  Work energies are whole
+    // ticks (multiples of 10); one tick of travel or work costs 10 energy.
+    struct Worker
+    {
+        int energy = 0;        // most it may spend
+        int horizon = 0;       // latest tick a task may finish on
+        std::vector<int> leg;  // leg[a * n + b]: energy from task a to task b, INF if none
+        std::vector<int> work; // energy to work each task, INF if it cannot
+        // (energy, finish tick) of a route that starts with each task; an
+        // energy of INF means the worker cannot start with it
+        std::vector<std::pair<int, int>> first;
+    };
+
+    // release: earliest tick each task can be worked, or null when every task
+    // already is.  nofore: a worker may not set off toward a task before its
+    // release either.  pool may be null.  Returns false when `deadline`
+    // passed before the plan was complete.
+    bool solve(int n, const std::vector<Worker> &workers, const int *release, bool nofore,
+               ThreadPool *pool, const Deadline &deadline = Deadline())
+    {
+        num = n;
+        ws = &workers;
+        rel = release;
+        no_fore = nofore;
+        dl = &deadline;
+        late = false;
+        const int threads = pool ? pool->size() : 1;
+        if (static_cast<int>(scratch.size()) < threads)
+            scratch.resize(threads);
+        lists.assign(workers.size(), std::vector<SubsetE>());
+        for (size_t i = 0; i < scratch.size(); ++i)
+            scratch[i].states = 0;
+        parts_expanded = 0;
+        if (pool)
+            pool->run(static_cast<int>(workers.size()),
+                      [this](int k, int thread) { subsets_of(k, scratch[thread]); });
+        else
+            for (size_t k = 0; k < workers.size(); ++k)
+                subsets_of(static_cast<int>(k), scratch[0]);
+        if (late)
+            return false;
+        partition(pool);
+        return !late;
+    }
+
+    int count() const { return best_cnt; }
+    // DP states the last solve expanded: per-worker route states plus
+    // partition unions
+    long long states() const
+    {
+        long long t = parts_expanded;
+        for (size_t i = 0; i < scratch.size(); ++i)
+            t += scratch[i].states;
+        return t;
+    }
+    int energy() const { return best_eng; }
+    // the subset each worker serves in the best plan
+    const std::vector<int> &pick() const { return picks; }
+    // every subset worker k can serve, sorted
+    const std::vector<SubsetE> &subsets(size_t k) const { return lists[k]; }
+    int best_energy(size_t k, int T) const
+    {
+        const std::vector<SubsetE> &v = lists[k];
+        std::vector<SubsetE>::const_iterator it = std::lower_bound(v.begin(), v.end(), SubsetE(T, -INF));
+        return (it != v.end() && it->first == T) ? it->second : INF;
+    }
+
+private:
+    struct Pareto
+    {
+        int S, last, off, len; // frontier = arena[off, off + len), by energy
+        bool operator<(const Pareto &o) const { return S != o.S ? S < o.S : last < o.last; }
+    };
+    struct Part
+    {
+        int U, cnt, eng, T; // T = subset the current worker took to get here
+        bool operator<(const Part &o) const { return U < o.U; }
+        bool beats(const Part &o) const { return cnt > o.cnt || (cnt == o.cnt && eng < o.eng); }
+    };
+    struct Scratch
+    {
+        std::vector<Pareto> layer, next_layer;
+        std::vector<std::pair<int, int>> arena, next_arena, cand; // (energy, finish tick)
+        std::vector<int> where;                                   // union -> slot in `parts`
+        std::vector<Part> parts;
+        long long states = 0;
+    };
+
+    void subsets_of(int k, Scratch &s)
+    {
+        const Worker &w = (*ws)[k];
+        const int n = num;
+        std::vector<SubsetE> &out = lists[k];
+        s.layer.clear();
+        s.arena.clear();
+        for (int j = 0; j < n; ++j)
+        {
+            if (w.first[j].first >= INF)
+                continue;
+            Pareto ps = {1 << j, j, static_cast<int>(s.arena.size()), 1};
+            s.arena.push_back(w.first[j]);
+            s.layer.push_back(ps);
+            ++s.states;
+            out.push_back(SubsetE(1 << j, w.first[j].first));
+        }
+        std::sort(s.layer.begin(), s.layer.end());
+        // the deadline is polled per predecessor state extended, so the gap
+        // between polls does not depend on how the layer's subsets are grouped
+        size_t work = 0;
+        while (!s.layer.empty())
+        {
+            s.next_layer.clear();
+            s.next_arena.clear();
+            // all states sharing a subset S sit together; (S + j, j) can only
+            // be reached from them
+            for (size_t g0 = 0, g1; g0 < s.layer.size(); g0 = g1)
+            {
+                int S = s.layer[g0].S;
+                for (g1 = g0; g1 < s.layer.size() && s.layer[g1].S == S; ++g1)
+                    ;
+                for (int j = 0; j < n; ++j)
+                {
+                    if (((S >> j) & 1) || w.work[j] >= INF)
+                        continue;
+                    s.cand.clear();
+                    for (size_t g = g0; g < g1; ++g)
+                    {
+                        if (expired(work++))
+                            return;
+                        int legc = w.leg[s.layer[g].last * n + j];
+                        if (legc >= INF)
+                            continue;
+                        for (int c = s.layer[g].off; c < s.layer[g].off + s.layer[g].len; ++c)
+                        {
+                            int e = s.arena[c].first + legc + w.work[j];
+                            if (e > w.energy)
+                                continue;
+                            int depart = s.arena[c].second;
+                            if (rel && no_fore && depart < rel[j])
+                                depart = rel[j];
+                            int start = depart + legc / 10;
+                            if (rel && start < rel[j])
+                                start = rel[j];
+                            int t = start + w.work[j] / 10;
+                            if (t > w.horizon)
+                                continue;
+                            s.cand.push_back(std::make_pair(e, t));
+                        }
+                    }
+                    if (s.cand.empty())
+                        continue;
+                    // dominance prune: by energy, keep only strictly earlier finishes
+                    std::sort(s.cand.begin(), s.cand.end());
+                    Pareto ps = {S | (1 << j), j, static_cast<int>(s.next_arena.size()), 0};
+                    int tmin = INF;
+                    for (size_t c = 0; c < s.cand.size(); ++c)
+                        if (s.cand[c].second < tmin)
+                        {
+                            tmin = s.cand[c].second;
+                            s.next_arena.push_back(s.cand[c]);
+                            ++ps.len;
+                        }
+                    s.next_layer.push_back(ps);
+                    s.states += ps.len;
+                    out.push_back(SubsetE(ps.S, s.cand[0].first));
+                }
+            }
+            std::sort(s.next_layer.begin(), s.next_layer.end());
+            s.layer.swap(s.next_layer);
+            s.arena.swap(s.next_arena);
+        }
+        // one entry per subset, carrying the cheapest way to end it
+        std::sort(out.begin(), out.end());
+        size_t m = 0;
+        for (size_t i = 0; i < out.size(); ++i)
+            if (m > 0 && out[m - 1].first == out[i].first)
+                out[m - 1].second = std::min(out[m - 1].second, out[i].second);
+            else
+                out[m++] = out[i];
+        out.resize(m);
+    }
+
+    // Extends the unions cur[b, e) by every subset worker k can serve,
+    // keeping the first best candidate per union in s.parts.
+    void extend(size_t k, size_t b, size_t e, Scratch &s)
+    {
+        const std::vector<SubsetE> &opts = lists[k];
+        if (s.where.size() != static_cast<size_t>(1) << num)
+            s.where.assign(static_cast<size_t>(1) << num, -1);
+        s.parts.clear();
+        for (size_t i = b; i < e && !expired(i - b); ++i)
+        {
+            const Part &from = cur[i];
+            for (size_t q = 0; q <= opts.size(); ++q)
+            {
+                // q == 0: worker k serves nothing and stays where it is
+                int T = q ? opts[q - 1].first : 0;
+                if (T & from.U)
+                    continue;
+                Part p = {from.U | T, from.cnt + popcount(T), from.eng + (q ? opts[q - 1].second : 0), T};
+                int &slot = s.where[p.U];
+                if (slot < 0)
+                {
+                    slot = static_cast<int>(s.parts.size());
+                    s.parts.push_back(p);
+                }
+                else if (p.beats(s.parts[slot]))
+                    s.parts[slot] = p;
+            }
+        }
+        for (size_t i = 0; i < s.parts.size(); ++i)
+            s.where[s.parts[i].U] = -1;
+    }
+
+    void partition(ThreadPool *pool)
+    {
+        const size_t nw = ws->size();
+        cur.assign(1, Part());
+        cur[0].U = cur[0].cnt = cur[0].eng = cur[0].T = 0;
+        choice.assign(nw, std::vector<std::pair<int, int>>());
+        if (where.size() != static_cast<size_t>(1) << num)
+            where.assign(static_cast<size_t>(1) << num, -1);
+        for (size_t k = 0; k < nw; ++k)
+        {
+            // chunks only pay off once there are enough pairs to split
+            size_t chunks = 1;
+            if (pool && pool->size() > 1 && cur.size() * (lists[k].size() + 1) >= PARALLEL_MIN)
+                chunks = std::min(cur.size(), static_cast<size_t>(pool->size()) * 4);
+            nxt.clear();
+            if (chunks == 1)
+            {
+                extend(k, 0, cur.size(), scratch[0]);
+                nxt.swap(scratch[0].parts);
+            }
+            else
+            {
+                chunk_parts.resize(chunks);
+                pool->run(static_cast<int>(chunks), [&](int c, int thread) {
+                    Scratch &s = scratch[thread];
+                    extend(k, cur.size() * c / chunks, cur.size() * (c + 1) / chunks, s);
+                    chunk_parts[c].swap(s.parts);
+                });
+                for (size_t c = 0; c < chunks; ++c)
+                    for (size_t i = 0; i < chunk_parts[c].size(); ++i)
+                    {
+                        const Part &p = chunk_parts[c][i];
+                        int &slot = where[p.U];
+                        if (slot < 0)
+                        {
+                            slot = static_cast<int>(nxt.size());
+                            nxt.push_back(p);
+                        }
+                        else if (p.beats(nxt[slot]))
+                            nxt[slot] = p;
+                    }
+                for (size_t i = 0; i < nxt.size(); ++i)
+                    where[nxt[i].U] = -1;
+            }
+            std::sort(nxt.begin(), nxt.end());
+            parts_expanded += static_cast<long long>(nxt.size());
+            choice[k].resize(nxt.size());
+            for (size_t i = 0; i < nxt.size(); ++i)
+                choice[k][i] = std::make_pair(nxt[i].U, nxt[i].T);
+            cur.swap(nxt);
+            if (late)
+                return;
+        }
+        size_t best = 0;
+        for (size_t i = 0; i < cur.size(); ++i)
+            if (cur[i].beats(cur[best]))
+                best = i;
+        best_cnt = cur[best].cnt;
+        best_eng = cur[best].eng;
+        picks.assign(nw, 0);
+        for (int k = static_cast<int>(nw) - 1, U = cur[best].U; k >= 0; --k)
+        {
+            picks[k] = std::lower_bound(choice[k].begin(), choice[k].end(), std::make_pair(U, -1))->second;
+            U &= ~picks[k];
+        }
+    }
+
+    // Polls the deadline every 64th step of a loop; once it has passed, every
+    // thread sees `late` and unwinds.
+    bool expired(size_t step)
+    {
+        if (late)
+            return true;
+        if ((step & 63) == 0 && dl->passed())
+            late = true;
+        return late;
+    }
+
+    static int popcount(int v)
+    {
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt(static_cast<unsigned>(v)));
+#else
+        return __builtin_popcount(v);
+#endif
+    }
+
+    static const size_t PARALLEL_MIN = 1 << 16;
+
+    int num = 0;
+    const std::vector<Worker> *ws = nullptr;
+    const int *rel = nullptr;
+    bool no_fore = false;
+    const Deadline *dl = nullptr;
+    std::atomic<bool> late{false};
+    std::vector<std::vector<SubsetE>> lists;
+    std::vector<Scratch> scratch; // one per pool thread
+    std::vector<Part> cur, nxt;
+    std::vector<std::vector<Part>> chunk_parts;
+    std::vector<int> where;
+    std::vector<std::vector<std::pair<int, int>>> choice; // (U, T), sorted by U
+    long long parts_expanded = 0;
+    std::vector<int> picks;
+    int best_cnt = 0, best_eng = 0;
+};
+
+#endif // EXACT_PLAN_H_
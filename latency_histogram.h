@@ -0,0 +1,91 @@
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// HDR-style histogram of latencies in nanoseconds: log-linear buckets, each
+// power of two split into SUB equal sub-buckets, so any recorded value is
+// known to within 1 / SUB (under 1.6%) of itself from 1 ns up to hours, in a
+// fixed few KB, with O(1) record.  Percentiles are reported as the upper edge
+// of the bucket they fall in -- never below the true value -- and the
+// maximum is kept exactly.  Histograms of several runs merge by adding counts.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : counts(static_cast<size_t>(RANGES) * SUB, 0) {}
+
+    void record(long long ns)
+    {
+        if (ns < 0)
+            ns = 0;
+        ++counts[bucket(static_cast<uint64_t>(ns))];
+        ++n;
+        sum += ns;
+        hi = std::max(hi, ns);
+    }
+    void merge(const LatencyHistogram &o)
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+            counts[i] += o.counts[i];
+        n += o.n;
+        sum += o.sum;
+        hi = std::max(hi, o.hi);
+    }
+
+    long long count() const { return n; }
+    long long max() const { return hi; }
+    double mean() const { return n ? static_cast<double>(sum) / n : 0.0; }
+    // Smallest bucket edge with at least q (0..1) of the values at or below
+    // it, capped at the exact maximum.  0 when empty.
+    long long percentile(double q) const
+    {
+        if (n == 0)
+            return 0;
+        long long rank = static_cast<long long>(std::ceil(q * static_cast<double>(n)));
+        rank = std::min(std::max(rank, 1LL), n);
+        long long seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+                return std::min(upper_edge(i), hi);
+        }
+        return hi;
+    }
+
+private:
+    static const int SUB_BITS = 6;
+    static const int SUB = 1 << SUB_BITS;
+    static const int RANGES = 64 - SUB_BITS + 1;
+
+    // Values below SUB get a bucket each; above, the top SUB_BITS + 1 bits
+    // pick it.
+    static size_t bucket(uint64_t v)
+    {
+        if (v < static_cast<uint64_t>(SUB))
+            return static_cast<size_t>(v);
+        int msb = 63;
+        while (!((v >> msb) & 1))
+            --msb;
+        int shift = msb - SUB_BITS;
+        return static_cast<size_t>(shift + 1) * SUB + static_cast<size_t>((v >> shift) - SUB);
+    }
+    static long long upper_edge(size_t b)
+    {
+        if (b < static_cast<size_t>(SUB))
+            return static_cast<long long>(b);
+        int shift = static_cast<int>(b / SUB) - 1;
+        uint64_t lo = (static_cast<uint64_t>(b % SUB) + SUB) << shift;
+        return static_cast<long long>(lo + ((1ULL << shift) - 1));
+    }
+
+    std::vector<long long> counts;
+    long long n = 0;
+    long long sum = 0;
+    long long hi = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_H_
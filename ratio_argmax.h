@@ -0,0 +1,168 @@
+#ifndef RATIO_ARGMAX_H_
+#define RATIO_ARGMAX_H_
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RATIO_ARGMAX_X86 1
+#include <immintrin.h>
+#endif
+
+// Value-per-energy target scan over a run of cells: the first i maximising
+//
+//     g[i] * 1000 / (d[i] + k)          (integer division)
+//
+// among the cells with g[i] > 0, d[i] <= max_d, d[i] + k > 0 and i != skip
+// (ratios are assumed to fit in an int, as in the loop below).  A cell with
+// no positive denominator is skipped, so no path divides by zero or compares
+// an infinite or NaN ratio.  `best` is the
+// running best of the caller's scan, and `best`/`at` are only replaced by a
+// strictly better cell -- exactly what the scalar loop
+//
+//     if (ratio > best) { best = ratio; at = i; }
+//
+// over the same cells in order leaves behind.  The vector paths work in
+// doubles: g * 1000 < 2^52 for any int g, so the quotient is correctly
+// rounded and its floor is the integer quotient.  The widest path the CPU
+// supports is picked once at run time; nothing needs -mavx2 to build.
+// RATIO_ARGMAX_LEVEL=0/1/2 caps it at scalar / SSE4.1 / AVX2, to compare the
+// paths in place; bench/verify_ratio checks them against each other.
+class RatioArgmax
+{
+public:
+    static void scan(const int *g, const int *d, int count, int max_d, int k, int skip, int &best, int &at)
+    {
+#ifdef RATIO_ARGMAX_X86
+        static const int lvl = level();
+        if (lvl == 2)
+            return scan_avx2(g, d, count, max_d, k, skip, best, at);
+        if (lvl == 1)
+            return scan_sse41(g, d, count, max_d, k, skip, best, at);
+#endif
+        scan_scalar(g, d, count, max_d, k, skip, best, at);
+    }
+
+    static void scan_scalar(const int *g, const int *d, int count, int max_d, int k, int skip, int &best, int &at)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (g[i] <= 0 || d[i] > max_d || d[i] + k <= 0 || i == skip)
+                continue;
+            int ratio = static_cast<int>(static_cast<long long>(g[i]) * 1000 / (d[i] + k));
+            if (ratio > best)
+            {
+                best = ratio;
+                at = i;
+            }
+        }
+    }
+
+#ifdef RATIO_ARGMAX_X86
+    // 2 (AVX2), 1 (SSE4.1) or 0 (scalar): the widest the CPU supports, no
+    // wider than RATIO_ARGMAX_LEVEL.
+    static int level()
+    {
+        const char *cap = getenv("RATIO_ARGMAX_LEVEL");
+        return cap ? std::min(atoi(cap), supported()) : supported();
+    }
+    static int supported()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return 2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return 1;
+        return 0;
+    }
+
+    // Each lane keeps its own first maximum (a lane sees its cells in
+    // order); the lanes are then merged by value, ties to the lower index,
+    // and the tail is finished in scalar order after them.
+    __attribute__((target("avx2"))) static void scan_avx2(const int *g, const int *d, int count, int max_d, int k,
+                                                          int skip, int &best, int &at)
+    {
+        const __m128i zero = _mm_setzero_si128(), vmax = _mm_set1_epi32(max_d), vskip = _mm_set1_epi32(skip);
+        const __m128i vki = _mm_set1_epi32(k);
+        const __m256d thousand = _mm256_set1_pd(1000.0), vk = _mm256_set1_pd(k), none = _mm256_set1_pd(-1.0);
+        __m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i step = _mm_set1_epi32(4);
+        __m256d lane_q = none, lane_i = none;
+        int i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i gi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(g + i));
+            __m128i di = _mm_loadu_si128(reinterpret_cast<const __m128i *>(d + i));
+            __m128i ok = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(di, vmax), _mm_cmpeq_epi32(idx, vskip)),
+                                          _mm_and_si128(_mm_cmpgt_epi32(gi, zero),
+                                                        _mm_cmpgt_epi32(_mm_add_epi32(di, vki), zero)));
+            __m256d q = _mm256_floor_pd(_mm256_div_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(gi), thousand),
+                                                      _mm256_add_pd(_mm256_cvtepi32_pd(di), vk)));
+            q = _mm256_blendv_pd(none, q, _mm256_castsi256_pd(_mm256_cvtepi32_epi64(ok)));
+            __m256d up = _mm256_cmp_pd(q, lane_q, _CMP_GT_OQ);
+            lane_q = _mm256_blendv_pd(lane_q, q, up);
+            lane_i = _mm256_blendv_pd(lane_i, _mm256_cvtepi32_pd(idx), up);
+            idx = _mm_add_epi32(idx, step);
+        }
+        double qs[4], is[4];
+        _mm256_storeu_pd(qs, lane_q);
+        _mm256_storeu_pd(is, lane_i);
+        finish(qs, is, 4, g, d, i, count, max_d, k, skip, best, at);
+    }
+
+    __attribute__((target("sse4.1"))) static void scan_sse41(const int *g, const int *d, int count, int max_d,
+                                                             int k, int skip, int &best, int &at)
+    {
+        const __m128i zero = _mm_setzero_si128(), vmax = _mm_set1_epi32(max_d), vskip = _mm_set1_epi32(skip);
+        const __m128i vki = _mm_set1_epi32(k);
+        const __m128d thousand = _mm_set1_pd(1000.0), vk = _mm_set1_pd(k), none = _mm_set1_pd(-1.0);
+        __m128i idx = _mm_setr_epi32(0, 1, 0, 0);
+        const __m128i step = _mm_setr_epi32(2, 2, 0, 0);
+        __m128d lane_q = none, lane_i = none;
+        int i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128i gi = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(g + i));
+            __m128i di = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(d + i));
+            __m128i ok = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(di, vmax), _mm_cmpeq_epi32(idx, vskip)),
+                                          _mm_and_si128(_mm_cmpgt_epi32(gi, zero),
+                                                        _mm_cmpgt_epi32(_mm_add_epi32(di, vki), zero)));
+            __m128d q = _mm_floor_pd(_mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(gi), thousand),
+                                                _mm_add_pd(_mm_cvtepi32_pd(di), vk)));
+            q = _mm_blendv_pd(none, q, _mm_castsi128_pd(_mm_cvtepi32_epi64(ok)));
+            __m128d up = _mm_cmpgt_pd(q, lane_q);
+            lane_q = _mm_blendv_pd(lane_q, q, up);
+            lane_i = _mm_blendv_pd(lane_i, _mm_cvtepi32_pd(idx), up);
+            idx = _mm_add_epi32(idx, step);
+        }
+        double qs[2], is[2];
+        _mm_storeu_pd(qs, lane_q);
+        _mm_storeu_pd(is, lane_i);
+        finish(qs, is, 2, g, d, i, count, max_d, k, skip, best, at);
+    }
+
+    static void finish(const double *qs, const double *is, int lanes, const int *g, const int *d, int i,
+                       int count, int max_d, int k, int skip, int &best, int &at)
+    {
+        double q = -1.0, qi = -1.0;
+        for (int l = 0; l < lanes; ++l)
+            if (qs[l] > q || (qs[l] == q && is[l] < qi))
+            {
+                q = qs[l];
+                qi = is[l];
+            }
+        int vbest = q < 0 ? -1 : static_cast<int>(q), vat = static_cast<int>(qi);
+        int tail_at = -1;
+        scan_scalar(g + i, d + i, count - i, max_d, k, skip - i, vbest, tail_at);
+        if (tail_at >= 0)
+            vat = i + tail_at;
+        if (vat >= 0 && vbest > best)
+        {
+            best = vbest;
+            at = vat;
+        }
+    }
+#endif
+};
+
+#endif // RATIO_ARGMAX_H_
@@ -1,9 +1,15 @@
 #include "schedular.h"
+#include "bucket_queue.h"
+#include "deadline.h"
+#include "exact_plan.h"
+#include "ratio_argmax.h"
+#include "tick_profile.h"
 
 #include <algorithm>
 #include <cstdlib>
+#include <iterator>
 #include <map>
-#include <queue>
+#include <memory>
 #include <utility>
 
 // ---------------------------------------------------------------------------
@@ -52,8 +58,30 @@
 //    to finish; a robot standing on a task may also opportunistically take it
 //    over when that is cheaper than the booked robot's remaining travel+work.
 //
-//  * Everything is replanned from scratch every tick; no state survives that
-//    the simulator could contradict.
+//  * Decisions are re-derived every tick, but the work behind them is carried
+//    over, and each piece of carried state has one invalidation rule:
+//      - per-robot distance fields (routed and clean) are LPA* fields repaired
+//        from the cells whose cost changed or whose magnet flipped; a moved
+//        source, a skipped tick or a field_epoch bump (every unknown cell's
+//        estimate moved) rebuilds them from scratch;
+//      - task distance maps live in a slot arena keyed by task id, checked
+//        against per-region map versions, and are evicted when the task is no
+//        longer free to plan;
+//      - last tick's routes (prev_route) only seed the fleet plan, which is
+//        re-solved and re-checked against this tick's energies;
+//      - the observation mass and edge value grids are patched at the cells
+//        observed this tick; tables that missed a tick are rebuilt;
+//      - bookkeeping keyed by id (first_seen, work_since, drone goals and
+//        bands, assignments) is dropped or re-validated against what the
+//        simulator reports each tick;
+//      - the task snapshot, the robot table and the live robots follow the
+//        events of on_delta, and are seeded from a full scan when a tick
+//        comes without one.
+//    The caches give exactly what a from-scratch computation would.  The
+//    deliberate memory -- prev_route, drone goals, assignments, and in
+//    anytime mode the free-task count whose exact plan ran out of time --
+//    does steer decisions, so a copy of the Scheduler carries all of it (and
+//    the caches with it): SIMULATION snapshots hold one.
 // ---------------------------------------------------------------------------
 
 namespace
@@ -103,10 +131,22 @@ namespace
     int PATROL_MIN_ENERGY = 1400;// a worker below this keeps its energy for tasks
     int PATROL_MIN_RATIO = 300; // workers see fewer cells per step than drones
     int PATROL_DISPERSE = 1200; // x1000 weight pushing patrols away from other workers
+    int SERVE_MSRC = 200;       // workers from which serve_dist and the patrol's nearest-worker
+                                // field come from one search per type instead of a min
+                                // over every worker's field (0 = always).  Both give the
+                                // same values; the search wins past ~200 workers.
     int PLAN_SLACK = 0;   // ticks of margin a route must finish inside
     int PLAN_ITERS = 12;        // local-search rounds per tick
     int EXACT_MAX = 16;         // solve the fleet plan exactly when at most this many
                                 // free tasks are known (0 = always use local search)
+    int PLAN_THREADS = 1;       // threads the exact plan may use (1 = run it serially)
+    int PLAN_DEADLINE_US = 0;   // per-tick planning budget in microseconds, counted from
+                                // the start of on_info_updated (0 = no deadline: run
+                                // PLAN_ITERS rounds and the exact plan to completion).
+                                // It bounds the fleet plan only (exact, insertion, local
+                                // search); the fields, serve_dist, drones and patrol
+                                // always run in full, so it is no bound on tick latency
+    int EXACT_REPROBE = 200;    // ticks before an exact plan that ran out of time is retried
     int PATROL_LATE_T = 1200;   // after this tick there is nothing left to save for
     int PATROL_LATE_ENERGY = 50; // so the patrol floor drops to here
     int DRONE_PACE_T = 1900;    // ticks over which a drone's fuel is spread (0 = no pacing).
@@ -145,12 +185,8 @@ namespace
 
     inline int ceil10(int v) { return (v + 9) / 10; }
 
-    void load_tunables()
+    void read_tunables()
     {
-        static bool done = false;
-        if (done)
-            return;
-        done = true;
         SERVE_W_HI = envd("SCHED_T_SWHI", SERVE_W_HI);
         SERVE_W_LO = envd("SCHED_T_SWLO", SERVE_W_LO);
         SERVE_W_SLOPE = envd("SCHED_T_SWSL", SERVE_W_SLOPE);
@@ -167,8 +203,12 @@ namespace
         DRONE_STEP_EST = envi("SCHED_T_DSTEP", DRONE_STEP_EST);
         DRONE_TAIL_FLOOR = envi("SCHED_T_DTAIL", DRONE_TAIL_FLOOR);
         PATROL_DISPERSE = envi("SCHED_T_PDISP", PATROL_DISPERSE);
+        SERVE_MSRC = envi("SCHED_T_MSRC", SERVE_MSRC);
         PLAN_ITERS = envi("SCHED_T_PITER", PLAN_ITERS);
         EXACT_MAX = envi("SCHED_T_EXACT", EXACT_MAX);
+        PLAN_THREADS = envi("SCHED_T_THREADS", PLAN_THREADS);
+        PLAN_DEADLINE_US = envi("SCHED_T_DEADLINE", PLAN_DEADLINE_US);
+        EXACT_REPROBE = envi("SCHED_T_EXREPROBE", EXACT_REPROBE);
         PATROL_LATE_T = envi("SCHED_T_PLATE", PATROL_LATE_T);
         PATROL_LATE_ENERGY = envi("SCHED_T_PMEL", PATROL_LATE_ENERGY);
         WORKER_TRAVEL_CAP = envi("SCHED_T_WTC", WORKER_TRAVEL_CAP);
@@ -181,6 +221,14 @@ namespace
         ASSIGN_STICKY = envd("SCHED_T_STICKY", ASSIGN_STICKY);
     }
 
+    // Read once per process.  A function-local static is initialised exactly
+    // once even when schedulers on several threads start together.
+    void load_tunables()
+    {
+        static const bool done = (read_tunables(), true);
+        (void)done;
+    }
+
     inline int work_energy(const TASK &task, ROBOT::TYPE type)
     {
         int c = task.get_cost(type);
@@ -191,6 +239,20 @@ namespace
             ticks = 1;
         return ticks * 10;
     }
+
+    // A member that is scratch space rather than state: a copy of the owner
+    // gets a freshly constructed one instead of a copy (solvers and thread
+    // pools cannot be copied, and nothing in them outlives a tick).
+    template <class T>
+    struct Fresh
+    {
+        T value;
+        Fresh() {}
+        Fresh(const Fresh &) {}
+        Fresh &operator=(const Fresh &) { return *this; }
+        T *operator->() { return &value; }
+        T &operator*() { return value; }
+    };
 }
 
 struct Scheduler::State
@@ -198,12 +260,58 @@ struct Scheduler::State
     int now = -1;
     int n = 0;           // map size
     int drone_cost = -1; // uniform drone cell cost once discovered
-    const vector<vector<vector<int>>> *cost_map = nullptr;
-    const vector<vector<OBJECT>> *obj_map = nullptr;
+    GRID_VIEW<int> cost_map;    // known costs, one plane per robot type
+    GRID_VIEW<OBJECT> obj_map;
 
     vector<vector<int>> last_seen; // [x][y] -> tick last observed (-1 never)
     vector<int> stale;             // flattened staleness grid (rebuilt per tick)
     vector<char> magnet;           // flattened: cell holds an unowned, undone task
+    vector<int> magnet_cells;      // the cells set in magnet, ascending
+
+    // Changes pushed through on_delta since the last on_info_updated; without
+    // them on_info_updated falls back to scanning what it is handed.
+    bool delta_fed = false;
+    vector<Coord> delta_revealed;
+    vector<MAP_DELTA::TASK_CHANGE> delta_tasks;
+    vector<MAP_DELTA::ROBOT_CHANGE> delta_robots;
+
+    // The task snapshot and the robot tables, kept from those events while
+    // deltas are fed.  act_ids replays the map's own push_back / swap-remove,
+    // so it lists the active tasks in active_tasks order; worked_by is the
+    // robot on each task, free_at the positions of the tasks free to plan and
+    // live the robots not yet exhausted.  A scan of the lists seeds them on
+    // the first fed tick, after a tick without a delta, and whenever the
+    // mirror disagrees with what it is handed.
+    bool events_synced = false;
+    bool tasks_changed = true; // free_at moved since the last tick
+    vector<int> act_ids;       // active task ids, in active_tasks order
+    vector<int> act_pos;       // task id -> position in act_ids (-1 none)
+    vector<int> worked_by;     // task id -> robot working it (-1 none)
+    vector<int> free_at;       // positions in active_tasks of the free tasks
+    vector<int> live;          // ids of the robots not yet exhausted
+    int max_id = 0;
+    size_t num_robots = 0;
+    vector<const ROBOT *> by_id; // robot id -> robot; emptied by a copy
+
+    void track_task(int id)
+    {
+        if (id >= static_cast<int>(act_pos.size()))
+        {
+            act_pos.resize(id + 1, -1);
+            worked_by.resize(id + 1, -1);
+        }
+    }
+    void seed_events(const vector<shared_ptr<TASK>> &active_tasks, const vector<shared_ptr<ROBOT>> &robots);
+    bool apply_events(size_t num_active);
+    bool free_tasks(const vector<shared_ptr<TASK>> &active_tasks, vector<const TASK *> &tasks);
+
+    vector<int> task_at_cell; // decide_all scratch: cell -> active task index, -1
+    TickProfile prof;         // the last on_info_updated, phase by phase
+
+    // The per-robot decisions, shared by on_task_reached / idle_action and
+    // decide_all (defined with them, at the end of the file).
+    bool reach_task(const vector<shared_ptr<ROBOT>> &robots, const ROBOT &robot, const TASK &task);
+    ROBOT::ACTION step_action(const GRID_VIEW<OBJECT> &known_object_map, const ROBOT &robot) const;
 
     // per robot id
     vector<int> init_energy;
@@ -226,19 +334,115 @@ struct Scheduler::State
                                          // target observes away its own value.
 
 
-    // per-tick cache: dijkstra maps sourced at task cells (for chain checks)
-    map<pair<int, int>, vector<int>> task_dist_cache; // (task id, type) -> dist
+    // Clean dijkstra maps sourced at task cells (for chain checks).  A task
+    // never moves and costs only change where a cell is first seen, so the
+    // maps persist across ticks: each lives in a slot of one flat arena
+    // (distances and LPA* lookahead side by side) and is repaired from the
+    // cells that changed since it was last used.  Changes are tracked by
+    // version: map_version counts ticks that changed anything, and every
+    // REGION x REGION block and every cell remembers the version it last
+    // changed at, so a refresh only looks inside blocks that moved.
+    static const int REGION = 8;
+    int map_version = 0;
+    int regions_per_row = 0;
+    vector<int> region_version; // block -> map_version of its last change
+    vector<int> cell_version;   // cell -> map_version of its last change
+    vector<int> task_slot;      // task id * 3 + type -> arena slot (-1 none)
+    vector<int> slot_key;       // slot -> task id * 3 + type (-1 free)
+    vector<int> slot_version;   // slot -> map_version it is current for
+    vector<int> slot_epoch;     // slot -> field_epoch it was built under
+    vector<int> free_slots;
+    vector<int> task_arena;     // slot s: [2s*N, 2s*N+N) dist, then N of rhs
     vector<int> scratch_par;
+    vector<int> scratch_dist;
+    vector<int> stale_cells;
+
+    // Record this tick's changed cells against their blocks.
+    void bump_versions(const vector<int> &changed)
+    {
+        if (changed.empty())
+            return;
+        ++map_version;
+        for (size_t i = 0; i < changed.size(); ++i)
+        {
+            int c = changed[i];
+            cell_version[c] = map_version;
+            region_version[(c / n) / REGION * regions_per_row + (c % n) / REGION] = map_version;
+        }
+    }
 
-    const vector<int> &dist_from_task(int task_id, int type, const Coord &c)
+    // Release the slots of tasks no longer in `live` (sorted task ids).
+    void evict_task_fields(const vector<int> &live)
     {
-        pair<int, int> key(task_id, type);
-        map<pair<int, int>, vector<int>>::iterator it = task_dist_cache.find(key);
-        if (it != task_dist_cache.end())
-            return it->second;
-        vector<int> d;
-        dijkstra(c, type, d, scratch_par, false);
-        return task_dist_cache[key] = d;
+        for (size_t slot = 0; slot < slot_key.size(); ++slot)
+        {
+            int key = slot_key[slot];
+            if (key < 0 || binary_search(live.begin(), live.end(), key / 3))
+                continue;
+            task_slot[key] = -1;
+            slot_key[slot] = -1;
+            free_slots.push_back(static_cast<int>(slot));
+        }
+    }
+
+    const int *dist_from_task(int task_id, int type, const Coord &c)
+    {
+        const int N = n * n;
+        int key = task_id * 3 + type;
+        if (static_cast<int>(task_slot.size()) <= key)
+            task_slot.resize(key + 1, -1);
+        int slot = task_slot[key];
+        bool rebuild = false;
+        if (slot < 0)
+        {
+            if (!free_slots.empty())
+            {
+                slot = free_slots.back();
+                free_slots.pop_back();
+            }
+            else
+            {
+                slot = static_cast<int>(slot_key.size());
+                slot_key.push_back(-1);
+                slot_version.push_back(-1);
+                slot_epoch.push_back(-1);
+                task_arena.resize(task_arena.size() + 2 * static_cast<size_t>(N));
+            }
+            task_slot[key] = slot;
+            slot_key[slot] = key;
+            rebuild = true;
+        }
+        int *d = &task_arena[2 * static_cast<size_t>(slot) * N];
+        int *rhs = d + N;
+        if (rebuild || slot_epoch[slot] != field_epoch)
+        {
+            prof.add(TickProfile::TASK_MAP_MISSES);
+            dijkstra(c, type, scratch_dist, scratch_par, false);
+            copy(scratch_dist.begin(), scratch_dist.end(), d);
+            copy(scratch_dist.begin(), scratch_dist.end(), rhs);
+        }
+        else if (slot_version[slot] != map_version)
+        {
+            prof.add(TickProfile::TASK_MAP_MISSES);
+            int since = slot_version[slot];
+            stale_cells.clear();
+            for (int r = 0; r < static_cast<int>(region_version.size()); ++r)
+            {
+                if (region_version[r] <= since)
+                    continue;
+                int x0 = r / regions_per_row * REGION, y0 = r % regions_per_row * REGION;
+                for (int x = x0; x < min(x0 + REGION, n); ++x)
+                    for (int y = y0; y < min(y0 + REGION, n); ++y)
+                        if (cell_version[idx(x, y)] > since)
+                            stale_cells.push_back(idx(x, y));
+            }
+            lpa_repair(idx(c), type, false, d, rhs, stale_cells);
+        }
+        else
+            prof.add(TickProfile::TASK_MAP_HITS);
+        slot_version[slot] = map_version;
+        slot_epoch[slot] = field_epoch;
+        return d;
     }
 
     // ---- basic helpers ----------------------------------------------------
@@ -249,7 +453,7 @@ struct Scheduler::State
     // Cell cost for pathfinding: -1 means impassable (known wall).
     int cell_cost(int x, int y, int t) const
     {
-        int c = (*cost_map)[x][y][t];
+        int c = cost_map.plane(t)[idx(x, y)];
         if (c == INFINITE)
             return -1;
         if (c < 0) // unknown cell: estimated, slightly pessimistic
@@ -260,70 +464,344 @@ struct Scheduler::State
         return c;
     }
 
+    // Observation value per (direction, cell) in closed form: ft * live - base
+    // (see edge_val).
+    struct EdgeVal
+    {
+        vector<int> live, base;
+        int ft = 0;
+        int operator[](int i) const { return ft * live[i] - base[i]; }
+    };
+
     // `tb`, when given, is a direction-indexed grid of observation value (see
-    // build_edge_val).  It never changes which cells are cheapest to reach --
+    // edge_val).  It never changes which cells are cheapest to reach --
     // it only decides *which* of the equally cheap paths is taken, so steering
     // by it costs exactly zero energy.  Shortest paths in this grid are rarely
     // unique, and the tie is otherwise settled by whichever order the queue
     // happened to pop, which is worth nothing at all.
+    //
+    // `settled`, when given, receives the reachable cells in the order they
+    // are settled, i.e. sorted by (distance, cell index).
     void dijkstra(const Coord &src, int type, vector<int> &d, vector<int> &p,
-                  bool use_magnet = true, const vector<int> *tb = 0) const
+                  bool use_magnet = true, const EdgeVal *tb = 0,
+                  vector<int> *settled = 0)
     {
+        prof.add(TickProfile::DIJKSTRA_RUNS);
         d.assign(n * n, PLAN_INF);
         p.assign(n * n, -1);
-        vector<int> pv;
+        vector<int> &pv = search_pv;
         if (tb)
             pv.assign(n * n, 0); // observation value collected along the path
-        typedef pair<int, int> QE; // (dist, node)
-        priority_queue<QE, vector<QE>, greater<QE>> pq;
+        // Step energies are multiples of 10 unless the magnet knob says
+        // otherwise; either way cells are settled in (dist, cell) order.
+        search_queue.reset(step_cap[type], TASK_MAGNET % 10 == 0 ? 10 : 1);
         int s = idx(src);
         d[s] = 0;
-        pq.push(QE(0, s));
-        while (!pq.empty())
+        search_queue.push(0, s);
+        if (settled)
+            settled->clear();
+        while (!search_queue.empty())
         {
-            QE top = pq.top();
-            pq.pop();
-            if (top.first != d[top.second])
-                continue;
-            int ux = top.second / n, uy = top.second % n;
-            int cu = cell_cost(ux, uy, type);
-            if (cu < 0)
-                continue;
-            for (int k = 0; k < 4; ++k)
+            int du = search_queue.pop_bucket(search_bucket);
+            for (size_t b = 0; b < search_bucket.size(); ++b)
             {
-                int vx = ux + DXS[k], vy = uy + DYS[k];
-                if (!in_map(vx, vy))
+                int u = search_bucket[b];
+                if (du != d[u])
+                    continue; // stale entry
+                if (settled)
+                    settled->push_back(u);
+                int ux = u / n, uy = u % n;
+                int cu = cell_cost(ux, uy, type);
+                if (cu < 0)
                     continue;
-                int cv = cell_cost(vx, vy, type);
-                if (cv < 0)
-                    continue;
-                int w = ceil10(cu / 2 + cv) * 10; // exact step energy (== 10 * ticks)
-                // pull worker paths across free tasks: they get grabbed en route
-                if (use_magnet && type != 0 && !magnet.empty() && magnet[idx(vx, vy)])
-                    w = max(10, w - TASK_MAGNET);
-                int nd = top.first + w;
-                int v = idx(vx, vy);
-                if (nd < d[v])
+                for (int k = 0; k < 4; ++k)
                 {
-                    d[v] = nd;
-                    p[v] = top.second;
-                    if (tb)
-                        pv[v] = pv[top.second] + (*tb)[k * n * n + v];
-                    pq.push(QE(nd, v));
+                    int vx = ux + DXS[k], vy = uy + DYS[k];
+                    if (!in_map(vx, vy))
+                        continue;
+                    int cv = cell_cost(vx, vy, type);
+                    if (cv < 0)
+                        continue;
+                    int v = idx(vx, vy);
+                    int nd = du + step_energy(cu, cv, v, type, use_magnet);
+                    if (nd < d[v])
+                    {
+                        d[v] = nd;
+                        p[v] = u;
+                        if (tb)
+                            pv[v] = pv[u] + (*tb)[k * n * n + v];
+                        search_queue.push(nd, v);
+                        prof.add(TickProfile::HEAP_PUSHES);
+                    }
+                    else if (tb && nd == d[v])
+                    {
+                        // same energy, so this is free: keep the better-observing one.
+                        // v cannot have been popped yet (nd > d[u] >= every popped
+                        // key), so nothing downstream has been settled from it.
+                        int cand = pv[u] + (*tb)[k * n * n + v];
+                        if (cand > pv[v])
+                        {
+                            pv[v] = cand;
+                            p[v] = u;
+                        }
+                    }
                 }
-                else if (tb && nd == d[v])
+            }
+        }
+    }
+
+    // Largest single step energy per type: sizes the bucket ring.  Any
+    // upper bound gives the same search order, so the cell cost maximum is
+    // kept as a running one over the cells that changed instead of rescanned.
+    int step_cap[3] = {0, 0, 0};
+    int cost_max[3] = {-1, -1, -1};
+    BucketQueue search_queue;
+    vector<int> search_bucket;
+    vector<int> search_pv;
+
+    void update_step_caps()
+    {
+        for (int t = 0; t < 3; ++t)
+        {
+            if (cost_max[t] < 0)
+            {
+                for (int x = 0; x < n; ++x)
+                    for (int y = 0; y < n; ++y)
+                        cost_max[t] = max(cost_max[t], cell_cost(x, y, t));
+            }
+            else
+            {
+                for (size_t i = 0; i < cost_changed.size(); ++i)
+                    cost_max[t] = max(cost_max[t], cell_cost(cost_changed[i] / n, cost_changed[i] % n, t));
+                int est = (t == 0 && drone_cost > 0) ? drone_cost : EST_CELL_COST[t];
+                cost_max[t] = max(cost_max[t], static_cast<int>(est * UNKNOWN_PEN[t])); // unknown cells
+            }
+            step_cap[t] = ceil10(cost_max[t] / 2 + cost_max[t]) * 10;
+        }
+    }
+
+    // Energy of one step into cell v, given both cells' costs.
+    int step_energy(int cu, int cv, int v, int type, bool use_magnet) const
+    {
+        int w = ceil10(cu / 2 + cv) * 10; // exact step energy (== 10 * ticks)
+        // pull worker paths across free tasks: they get grabbed en route
+        if (use_magnet && type != 0 && !magnet.empty() && magnet[v])
+            w = max(10, w - TASK_MAGNET);
+        return w;
+    }
+
+    // ---- incremental robot distance maps ------------------------------------
+    // Between ticks a robot's source rarely moves (a step takes tens of ticks)
+    // and only the cells in updated_coords, plus cells whose magnet flipped,
+    // change weight.  So each robot keeps its maps as an LPA* field (h = 0):
+    // d doubles as g, rhs is the one-step lookahead, and a tick only repairs
+    // the cells whose distance the changes actually reach.  A moved source or
+    // a missed tick rebuilds from scratch.  Distances are exact either way, so
+    // the result is the same dijkstra() would give.
+    struct Field
+    {
+        int src = -1;      // source cell of the distances
+        int stamp = -1;    // tick the field was last brought up to date
+        int epoch = -1;    // field_epoch it was built under
+        vector<int> rhs;   // min over predecessors u of d[u] + w(u, v)
+        vector<int> order; // reachable cells by (d, idx), as dijkstra settles them
+    };
+    int field_epoch = 0;        // bumped when every estimated cost changes at once
+    vector<int> cost_changed;   // cells whose known cost/object changed this tick
+    vector<int> route_changed;  // the same, plus cells whose magnet flipped
+    vector<Field> field;        // robot -> routed field (dist/par)
+    vector<Field> field_c;      // robot -> clean field (dist_c)
+    vector<pair<int, int>> lpa_heap; // (key, cell), min-heap via greater<>
+    vector<char> lpa_moved;
+    vector<int> lpa_moved_list;
+    vector<int> scratch_pv;
+
+    // Recompute rhs[v] from v's in-neighbours and queue v if inconsistent.
+    void lpa_update(int src, const int *d, int *rhs, int v, int type, bool use_magnet)
+    {
+        int vx = v / n, vy = v % n;
+        int best = PLAN_INF;
+        int cv = cell_cost(vx, vy, type);
+        if (v == src)
+            best = 0;
+        else if (cv >= 0)
+            for (int k = 0; k < 4; ++k)
+            {
+                int ux = vx - DXS[k], uy = vy - DYS[k];
+                if (!in_map(ux, uy))
+                    continue;
+                int u = idx(ux, uy);
+                int cu = cell_cost(ux, uy, type);
+                if (cu < 0 || d[u] >= PLAN_INF)
+                    continue;
+                best = min(best, d[u] + step_energy(cu, cv, v, type, use_magnet));
+            }
+        rhs[v] = best;
+        if (d[v] != best)
+        {
+            lpa_heap.push_back(make_pair(min(d[v], best), v));
+            prof.add(TickProfile::HEAP_PUSHES);
+            push_heap(lpa_heap.begin(), lpa_heap.end(), greater<pair<int, int>>());
+        }
+    }
+
+    void lpa_touch(int v)
+    {
+        if (!lpa_moved[v])
+        {
+            lpa_moved[v] = 1;
+            lpa_moved_list.push_back(v);
+        }
+    }
+
+    // LPA* repair of the distances d from `src` (rhs alongside) after the
+    // cells in `seeds` changed weight.  Cells whose distance moved are left in
+    // lpa_moved_list.
+    void lpa_repair(int src, int type, bool use_magnet, int *d, int *rhs, const vector<int> &seeds)
+    {
+        prof.add(TickProfile::LPA_REPAIRS);
+        if (static_cast<int>(lpa_moved.size()) != n * n)
+            lpa_moved.assign(n * n, 0);
+        for (size_t i = 0; i < lpa_moved_list.size(); ++i)
+            lpa_moved[lpa_moved_list[i]] = 0;
+        lpa_moved_list.clear();
+        lpa_heap.clear();
+        for (size_t i = 0; i < seeds.size(); ++i)
+        {
+            int c = seeds[i], cx = c / n, cy = c % n;
+            lpa_update(src, d, rhs, c, type, use_magnet);
+            for (int k = 0; k < 4; ++k)
+                if (in_map(cx + DXS[k], cy + DYS[k]))
+                    lpa_update(src, d, rhs, idx(cx + DXS[k], cy + DYS[k]), type, use_magnet);
+        }
+        while (!lpa_heap.empty())
+        {
+            pop_heap(lpa_heap.begin(), lpa_heap.end(), greater<pair<int, int>>());
+            pair<int, int> top = lpa_heap.back();
+            lpa_heap.pop_back();
+            int u = top.second;
+            if (d[u] == rhs[u] || top.first != min(d[u], rhs[u]))
+                continue; // stale entry
+            int ux = u / n, uy = u % n;
+            lpa_touch(u);
+            if (d[u] > rhs[u])
+            {
+                d[u] = rhs[u];
+                int cu = cell_cost(ux, uy, type);
+                for (int k = 0; k < 4 && cu >= 0; ++k)
                 {
-                    // same energy, so this is free: keep the better-observing one.
-                    // v cannot have been popped yet (nd > d[u] >= every popped
-                    // key), so nothing downstream has been settled from it.
-                    int cand = pv[top.second] + (*tb)[k * n * n + v];
-                    if (cand > pv[v])
+                    int vx = ux + DXS[k], vy = uy + DYS[k];
+                    if (!in_map(vx, vy))
+                        continue;
+                    int v = idx(vx, vy);
+                    int cv = cell_cost(vx, vy, type);
+                    if (cv < 0 || v == src)
+                        continue;
+                    int nd = d[u] + step_energy(cu, cv, v, type, use_magnet);
+                    if (nd < rhs[v])
                     {
-                        pv[v] = cand;
-                        p[v] = top.second;
+                        rhs[v] = nd;
+                        lpa_heap.push_back(make_pair(min(d[v], nd), v));
+                        prof.add(TickProfile::HEAP_PUSHES);
+                        push_heap(lpa_heap.begin(), lpa_heap.end(), greater<pair<int, int>>());
                     }
                 }
             }
+            else
+            {
+                d[u] = PLAN_INF;
+                lpa_update(src, d, rhs, u, type, use_magnet);
+                for (int k = 0; k < 4; ++k)
+                    if (in_map(ux + DXS[k], uy + DYS[k]))
+                        lpa_update(src, d, rhs, idx(ux + DXS[k], uy + DYS[k]), type, use_magnet);
+            }
+        }
+    }
+
+    // Bring f (distances in d) up to date for this tick; fills p when given.
+    void refresh_field(Field &f, const Coord &src, int type, vector<int> &d, vector<int> *p,
+                       bool use_magnet, const EdgeVal *tb)
+    {
+        int s = idx(src);
+        bool rebuild = f.src != s || f.stamp != now - 1 || f.epoch != field_epoch ||
+                       static_cast<int>(d.size()) != n * n;
+        f.stamp = now;
+        if (rebuild)
+        {
+            f.src = s;
+            f.epoch = field_epoch;
+            dijkstra(src, type, d, p ? *p : scratch_par, use_magnet, tb, &f.order);
+            f.rhs = d;
+            return;
+        }
+
+        lpa_repair(s, type, use_magnet, d.data(), f.rhs.data(),
+                   use_magnet && type != 0 ? route_changed : cost_changed);
+
+        // Settle order: the untouched cells keep their relative order, so
+        // drop the moved ones and merge them back in at their new distances.
+        if (!lpa_moved_list.empty())
+        {
+            vector<int> moved;
+            for (size_t i = 0; i < lpa_moved_list.size(); ++i)
+                if (d[lpa_moved_list[i]] < PLAN_INF)
+                    moved.push_back(lpa_moved_list[i]);
+            sort(moved.begin(), moved.end(), [&d](int a, int b)
+                 { return d[a] != d[b] ? d[a] < d[b] : a < b; });
+            vector<int> kept;
+            kept.reserve(f.order.size());
+            for (size_t i = 0; i < f.order.size(); ++i)
+                if (!lpa_moved[f.order[i]])
+                    kept.push_back(f.order[i]);
+            f.order.resize(kept.size() + moved.size());
+            merge(kept.begin(), kept.end(), moved.begin(), moved.end(), f.order.begin(),
+                  [&d](int a, int b)
+                  { return d[a] != d[b] ? d[a] < d[b] : a < b; });
+        }
+        // a weight change can swap which predecessor is tight without moving
+        // any distance, so parents are always re-derived
+        if (p)
+            field_parents(f, d, type, use_magnet, tb, *p);
+    }
+
+    // Parents exactly as dijkstra() would leave them.  It settles cells in
+    // (d, idx) order and keeps the first tight predecessor, or with `tb` the
+    // first one collecting the most observation value -- so walking the
+    // settle order and picking that predecessor reproduces it.
+    void field_parents(const Field &f, const vector<int> &d, int type, bool use_magnet,
+                       const EdgeVal *tb, vector<int> &p)
+    {
+        p.assign(n * n, -1);
+        if (tb)
+            scratch_pv.assign(n * n, 0);
+        for (size_t i = 0; i < f.order.size(); ++i)
+        {
+            int v = f.order[i];
+            if (v == f.src)
+                continue;
+            int vx = v / n, vy = v % n;
+            int cv = cell_cost(vx, vy, type);
+            int best = -1, best_val = 0;
+            for (int k = 0; k < 4; ++k)
+            {
+                int ux = vx - DXS[k], uy = vy - DYS[k];
+                if (!in_map(ux, uy))
+                    continue;
+                int u = idx(ux, uy);
+                int cu = cell_cost(ux, uy, type);
+                if (cu < 0 || d[u] >= PLAN_INF || d[u] + step_energy(cu, cv, v, type, use_magnet) != d[v])
+                    continue;
+                int val = tb ? scratch_pv[u] + (*tb)[k * n * n + v] : 0;
+                if (best < 0 || val > best_val ||
+                    (val == best_val && (d[u] < d[best] || (d[u] == d[best] && u < best))))
+                {
+                    best = u;
+                    best_val = val;
+                }
+            }
+            p[v] = best;
+            if (tb)
+                scratch_pv[v] = best_val;
         }
     }
 
@@ -349,6 +827,128 @@ struct Scheduler::State
     // weight observation value: a task found near a worker is cheap to serve,
     // one found in a far corner would mostly go unserved anyway.
     vector<int> serve_dist;
+    // near1[c] / near2[c] = smallest and second smallest clean distance to c
+    // over the workers still able to act, so any one of them can exclude
+    // itself.  Built with serve_dist when the patrol disperses, or by
+    // nearest_workers, which also leaves whose they are in near1_id/near2_id.
+    vector<int> near1, near2;
+    vector<int> near1_id, near2_id;
+
+    // Multi-source search: every worker in `ws` is a source at distance 0 and
+    // each cell keeps the labels of the first two distinct workers to settle
+    // it, one search per worker type (clean costs differ by type).  That is
+    // exact for both values: the second nearest worker's shortest path only
+    // crosses cells where it is itself one of the two nearest, or ties them.
+    // So one search per type replaces one field per worker.
+    void nearest_workers(const vector<const ROBOT *> &ws)
+    {
+        near1.assign(n * n, PLAN_INF);
+        near2.assign(n * n, PLAN_INF);
+        near1_id.assign(n * n, -1);
+        near2_id.assign(n * n, -1);
+        for (int type = 1; type < 3; ++type)
+        {
+            // tentative best two (distance, worker) per cell, slot 0 the
+            // smaller; a label only queues if it would enter them
+            msrc_d.assign(2 * n * n, PLAN_INF);
+            msrc_w.assign(2 * n * n, -1);
+            msrc_seen.assign(n * n, 0);
+            msrc_label.clear();
+            search_queue.reset(step_cap[type], 10);
+            for (size_t i = 0; i < ws.size(); ++i)
+                if (static_cast<int>(ws[i]->type) == type)
+                {
+                    Coord pos = (ws[i]->get_status() == ROBOT::STATUS::MOVING) ? ws[i]->get_target_coord()
+                                                                             : ws[i]->get_coord();
+                    msrc_offer(idx(pos), ws[i]->id, 0);
+                }
+            if (msrc_label.empty())
+                continue;
+            prof.add(TickProfile::DIJKSTRA_RUNS);
+            while (!search_queue.empty())
+            {
+                int du = search_queue.pop_bucket(search_bucket);
+                for (size_t b = 0; b < search_bucket.size(); ++b)
+                {
+                    int u = msrc_label[search_bucket[b]].first, w = msrc_label[search_bucket[b]].second;
+                    int slot = (msrc_w[2 * u] == w && msrc_d[2 * u] == du) ? 0
+                               : (msrc_w[2 * u + 1] == w && msrc_d[2 * u + 1] == du) ? 1
+                                                                                    : -1;
+                    if (slot < 0 || (msrc_seen[u] >> slot & 1))
+                        continue; // stale entry
+                    msrc_seen[u] |= 1 << slot;
+                    if (du < near1[u])
+                    {
+                        near2[u] = near1[u];
+                        near2_id[u] = near1_id[u];
+                        near1[u] = du;
+                        near1_id[u] = w;
+                    }
+                    else if (du < near2[u])
+                    {
+                        near2[u] = du;
+                        near2_id[u] = w;
+                    }
+                    int ux = u / n, uy = u % n;
+                    int cu = cell_cost(ux, uy, type);
+                    if (cu < 0)
+                        continue;
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        int vx = ux + DXS[k], vy = uy + DYS[k];
+                        if (!in_map(vx, vy))
+                            continue;
+                        int cv = cell_cost(vx, vy, type);
+                        if (cv >= 0)
+                            msrc_offer(idx(vx, vy), w, du + step_energy(cu, cv, idx(vx, vy), type, false));
+                    }
+                }
+            }
+        }
+    }
+    // Offer worker w's label nd at cell v to its tentative best two; queued
+    // when it gets in.  A settled slot is never displaced: nothing queued
+    // later is below it.
+    void msrc_offer(int v, int w, int nd)
+    {
+        int *d = &msrc_d[2 * v], *o = &msrc_w[2 * v];
+        if (o[0] == w)
+        {
+            if (nd >= d[0])
+                return;
+            d[0] = nd;
+        }
+        else if (o[1] == w)
+        {
+            if (nd >= d[1])
+                return;
+            d[1] = nd;
+        }
+        else
+        {
+            if (nd >= d[1])
+                return;
+            d[1] = nd;
+            o[1] = w;
+        }
+        if (d[1] < d[0])
+        {
+            swap(d[0], d[1]);
+            swap(o[0], o[1]);
+            swap_seen(v);
+        }
+        search_queue.push(nd, static_cast<int>(msrc_label.size()));
+        msrc_label.push_back(make_pair(v, w));
+        prof.add(TickProfile::HEAP_PUSHES);
+    }
+    void swap_seen(int v)
+    {
+        char f = msrc_seen[v];
+        msrc_seen[v] = static_cast<char>(((f & 1) << 1) | ((f >> 1) & 1));
+    }
+    vector<int> msrc_d, msrc_w;           // tentative (distance, worker), two per cell
+    vector<char> msrc_seen;               // which of a cell's two slots are settled
+    vector<pair<int, int>> msrc_label;    // queued (cell, worker) labels
 
     int horizon() const { return HORIZON_HARD_PER_CELL * n; }
 
@@ -379,15 +979,11 @@ struct Scheduler::State
     void build_staleness()
     {
         stale.assign(n * n, 0);
-        int ft = spawned_frac(now);
         int left = horizon() - now;
         for (int x = 0; x < n; ++x)
             for (int y = 0; y < n; ++y)
             {
-                if ((*obj_map)[x][y] == OBJECT::WALL)
-                    continue;
-                int ls = last_seen[x][y];
-                int mass = (ls < 0) ? (1000 + ft) : (ft - spawned_frac(ls));
+                int mass = obs_mass(idx(x, y));
                 if (mass <= 0)
                     continue;
                 double w = 1.0;
@@ -418,60 +1014,101 @@ struct Scheduler::State
                 }
                 stale[idx(x, y)] = static_cast<int>(mass * w);
             }
+        build_stale_sums();
     }
 
     // Value of the cells a robot standing at (cx,cy) would actually see.  The
     // view shape matters: a wheel sees a cross of 5 cells, not the 9 of the
     // square its radius suggests, and counting the square made wheel patrols
-    // look ~80% more productive than they are.
+    // look ~80% more productive than they are.  O(1) from the prefix sums: a
+    // cross is its row arm plus its column arm less the centre they share.
     int window_gain(int cx, int cy, int r, bool cross) const
     {
-        int g = 0;
         if (cross)
-        {
-            for (int xx = max(cx - r, 0); xx <= min(cx + r, n - 1); ++xx)
-                g += stale[idx(xx, cy)];
-            for (int yy = max(cy - r, 0); yy <= min(cy + r, n - 1); ++yy)
-                if (yy != cy)
-                    g += stale[idx(cx, yy)];
-            return g;
-        }
-        for (int xx = max(cx - r, 0); xx <= min(cx + r, n - 1); ++xx)
-            for (int yy = max(cy - r, 0); yy <= min(cy + r, n - 1); ++yy)
-                g += stale[idx(xx, yy)];
-        return g;
+            return rowsum(stale_pr, cy, cx - r, cx + r) + colsum(stale_pc, cx, cy - r, cy + r) -
+                   stale[idx(cx, cy)];
+        int x0 = max(cx - r, 0), x1 = min(cx + r, n - 1) + 1;
+        int y0 = max(cy - r, 0), y1 = min(cy + r, n - 1) + 1;
+        return static_cast<int>(stale_sat[x1 * (n + 1) + y1] - stale_sat[x0 * (n + 1) + y1] -
+                                stale_sat[x1 * (n + 1) + y0] + stale_sat[x0 * (n + 1) + y0]);
     }
 
-    // Is (px,py) inside the view of a robot standing at (cx,cy)?
-    bool in_view(int cx, int cy, int px, int py, int r, bool cross) const
+    // Value of the cells that come into view for the first time when stepping
+    // from u to the adjacent v.  For a 5x5 view moving one cell this is the
+    // leading column of five -- the other twenty were already visible from u
+    // and re-seeing them buys nothing -- so it is one prefix-sum difference.
+    int step_gain(int u, int v, int r, bool cross) const
     {
-        int ax = px - cx, ay = py - cy;
-        if (ax < 0)
-            ax = -ax;
-        if (ay < 0)
-            ay = -ay;
+        int vx = v / n, vy = v % n, dx = vx - u / n, dy = vy - u % n;
         if (cross)
-            return (ay == 0 && ax <= r) || (ax == 0 && ay <= r);
-        return ax <= r && ay <= r;
+        {
+            // the tip that appears ahead, plus the arm laid across the
+            // direction of travel; v itself was already in view from u
+            int px = vx + dx * r, py = vy + dy * r;
+            int tip = in_map(px, py) ? stale[idx(px, py)] : 0;
+            int arm = dx != 0 ? colsum(stale_pc, vx, vy - r, vy + r) : rowsum(stale_pr, vy, vx - r, vx + r);
+            return tip + arm - stale[v];
+        }
+        return dx != 0 ? colsum(stale_pc, vx + dx * r, vy - r, vy + r)
+                       : rowsum(stale_pr, vy + dy * r, vx - r, vx + r);
     }
 
-    // Value of the cells that come into view for the first time when stepping
-    // from u to v.  For a 5x5 view moving one cell this is the leading column
-    // of five -- the other twenty were already visible from u and re-seeing
-    // them buys nothing.
-    int step_gain(int ux, int uy, int vx, int vy, int r, bool cross) const
-    {
-        int g = 0;
-        for (int xx = max(vx - r, 0); xx <= min(vx + r, n - 1); ++xx)
-            for (int yy = max(vy - r, 0); yy <= min(vy + r, n - 1); ++yy)
+    // Column / row prefix sums of stale, built with it: pc[x*(n+1) + y] is
+    // the sum of column x over rows < y, pr[y*(n+1) + x] that of row y.
+    // stale_sat[x*(n+1) + y] is the sum over the rectangle [0,x) x [0,y); it
+    // is only needed while targets are scored by their window, and kept in
+    // 64 bits since it sums the whole map.
+    vector<int> stale_pc, stale_pr;
+    vector<long long> stale_sat;
+    vector<int> scan_gain; // a target scan's per-cell gain, when not a field as is
+
+    void build_stale_sums()
+    {
+        if (!SCOUT_PATHVAL || SCOUT_RECOMMIT > 0)
+        {
+            stale_sat.assign((n + 1) * (n + 1), 0);
+            for (int x = 0; x < n; ++x)
             {
-                if (cross && !in_view(vx, vy, xx, yy, r, true))
-                    continue;
-                if (in_view(ux, uy, xx, yy, r, cross))
-                    continue;
-                g += stale[idx(xx, yy)];
+                long long row = 0;
+                for (int y = 0; y < n; ++y)
+                {
+                    row += stale[idx(x, y)];
+                    stale_sat[(x + 1) * (n + 1) + y + 1] = stale_sat[x * (n + 1) + y + 1] + row;
+                }
             }
-        return g;
+        }
+        stale_pc.assign((n + 1) * n, 0);
+        stale_pr.assign((n + 1) * n, 0);
+        for (int x = 0; x < n; ++x)
+            for (int y = 0; y < n; ++y)
+                stale_pc[x * (n + 1) + y + 1] = stale_pc[x * (n + 1) + y] + stale[idx(x, y)];
+        for (int y = 0; y < n; ++y)
+            for (int x = 0; x < n; ++x)
+                stale_pr[y * (n + 1) + x + 1] = stale_pr[y * (n + 1) + x] + stale[idx(x, y)];
+    }
+    int colsum(const vector<int> &pc, int x, int a, int b) const
+    {
+        if (x < 0 || x >= n)
+            return 0;
+        if (a < 0)
+            a = 0;
+        if (b > n - 1)
+            b = n - 1;
+        if (a > b)
+            return 0;
+        return pc[x * (n + 1) + b + 1] - pc[x * (n + 1) + a];
+    }
+    int rowsum(const vector<int> &pr, int y, int a, int b) const
+    {
+        if (y < 0 || y >= n)
+            return 0;
+        if (a < 0)
+            a = 0;
+        if (b > n - 1)
+            b = n - 1;
+        if (a > b)
+            return 0;
+        return pr[y * (n + 1) + b + 1] - pr[y * (n + 1) + a];
     }
 
     // pg[v] = the observation value a walk from src to v collects *on the way*,
@@ -482,22 +1119,19 @@ struct Scheduler::State
     // with identical destination windows can differ by a whole sweep's worth of
     // coverage.  Costing the trip but not crediting it is what leaves cells
     // unobserved with the fuel already spent.
-    void path_gain(const vector<int> &d, const vector<int> &p, int r, bool cross,
+    //
+    // `order` is the field's settle order, so parents come before children and
+    // one pass suffices.
+    void path_gain(const vector<int> &order, const vector<int> &p, int r, bool cross,
                    vector<int> &pg) const
     {
         pg.assign(n * n, 0);
-        vector<pair<int, int>> ord; // (dist, cell), so parents come first
-        ord.reserve(n * n);
-        for (int i = 0; i < n * n; ++i)
-            if (d[i] < PLAN_INF)
-                ord.push_back(make_pair(d[i], i));
-        sort(ord.begin(), ord.end());
-        for (size_t i = 0; i < ord.size(); ++i)
-        {
-            int v = ord[i].second, u = p[v];
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            int v = order[i], u = p[v];
             if (u < 0)
                 continue; // the source itself: nothing collected yet
-            pg[v] = pg[u] + step_gain(u / n, u % n, v / n, v % n, r, cross);
+            pg[v] = pg[u] + step_gain(u, v, r, cross);
         }
     }
 
@@ -507,191 +1141,434 @@ struct Scheduler::State
     // because it can be built before the per-robot dijkstras, whereas the full
     // value cannot (it needs serve_dist, which needs those dijkstras) -- and a
     // path can only be steered by something that exists when it is planned.
-    vector<int> obs_mass;
+    //
+    // On a cell that is not a known wall the mass is ft - obs_base, where
+    // ft = spawned_frac(now) is one number for the whole grid and obs_base is
+    // -1000 for a never-seen cell, spawned_frac(ls) for one last seen at ls.
+    // Only observing a cell moves its base or reveals it as a wall, so the
+    // grid is patched at this tick's observed cells instead of rebuilt.
+    vector<int> obs_base;
+    vector<char> obs_live; // not a known wall
+    int obs_ft = 0;        // spawned_frac(now)
+
+    int obs_mass(int c) const { return obs_live[c] ? obs_ft - obs_base[c] : 0; }
 
-    void build_obs_mass()
+    // edge_val[type][k*n*n + v] = mass a robot of that type brings into view by
+    // stepping into cell v heading in direction k.  Each entry is a sum of
+    // cell masses, so it is kept in the same form -- how many live cells it
+    // sums and the total of their bases -- and read as ft * live - base; a
+    // changed cell touches only the entries whose view edge covers it.
+    EdgeVal edge_val[3];
+    int edge_stamp = -1; // tick the tables were last brought up to date
+
+    void update_obs_field(const CELL_BITMAP &observed, bool edges)
     {
-        obs_mass.assign(n * n, 0);
-        int ft = spawned_frac(now);
-        for (int x = 0; x < n; ++x)
-            for (int y = 0; y < n; ++y)
+        obs_ft = spawned_frac(now);
+        bool full = static_cast<int>(obs_base.size()) != n * n;
+        if (full)
+        {
+            obs_base.assign(n * n, 0);
+            obs_live.assign(n * n, 0);
+        }
+        // tables that missed a tick are rebuilt from the cells, not patched
+        bool edges_full = edges && (static_cast<int>(edge_val[0].live.size()) != 4 * n * n || edge_stamp != now - 1);
+        auto refresh = [&](int x, int y)
+        {
+            int c = idx(x, y), ls = last_seen[x][y];
+            char l = obj_map[x][y] != OBJECT::WALL;
+            int b = ls < 0 ? -1000 : spawned_frac(ls);
+            if (l == obs_live[c] && b == obs_base[c])
+                return;
+            if (edges && !edges_full)
+                patch_edge_val(x, y, l - obs_live[c], (l ? b : 0) - (obs_live[c] ? obs_base[c] : 0));
+            obs_live[c] = l;
+            obs_base[c] = b;
+        };
+        if (full)
+        {
+            for (int x = 0; x < n; ++x)
+                for (int y = 0; y < n; ++y)
+                    refresh(x, y);
+        }
+        else
+        {
+            for (const Coord c : observed)
+                refresh(c.x, c.y);
+        }
+        if (edges_full)
+        {
+            for (int ty = 0; ty < 3; ++ty)
             {
-                if ((*obj_map)[x][y] == OBJECT::WALL)
-                    continue;
-                int ls = last_seen[x][y];
-                int m = (ls < 0) ? (1000 + ft) : (ft - spawned_frac(ls));
-                if (m > 0)
-                    obs_mass[idx(x, y)] = m;
+                edge_val[ty].live.assign(4 * n * n, 0);
+                edge_val[ty].base.assign(4 * n * n, 0);
             }
+            for (int x = 0; x < n; ++x)
+                for (int y = 0; y < n; ++y)
+                    if (obs_live[idx(x, y)])
+                        patch_edge_val(x, y, 1, obs_base[idx(x, y)]);
+        }
+        for (int ty = 0; ty < 3; ++ty)
+            edge_val[ty].ft = obs_ft;
+        if (edges)
+            edge_stamp = now;
     }
 
-    // edge_val[type][k*n*n + v] = mass a robot of that type brings into view by
-    // stepping into cell v heading in direction k.  Row/column prefix sums make
-    // each entry O(1), so the whole table costs one pass over the grid.
-    vector<int> edge_val[3];
-
-    void build_edge_val()
+    // Add (dl live cells, db of base) at cell (cx,cy) to every edge entry
+    // whose newly seen cells include it.
+    void patch_edge_val(int cx, int cy, int dl, int db)
     {
-        vector<int> pc((n + 1) * n, 0), pr((n + 1) * n, 0);
-        for (int x = 0; x < n; ++x)
-            for (int y = 0; y < n; ++y)
-                pc[x * (n + 1) + y + 1] = pc[x * (n + 1) + y] + obs_mass[idx(x, y)];
-        for (int y = 0; y < n; ++y)
-            for (int x = 0; x < n; ++x)
-                pr[y * (n + 1) + x + 1] = pr[y * (n + 1) + x] + obs_mass[idx(x, y)];
         for (int ty = 0; ty < 3; ++ty)
         {
             int r = ROBOT::view_range_list[ty];
             bool cross = (ROBOT::view_type_list[ty] == ROBOT::VIEWTYPE::CROSS);
-            edge_val[ty].assign(4 * n * n, 0);
+            EdgeVal &e = edge_val[ty];
             for (int k = 0; k < 4; ++k)
-                for (int x = 0; x < n; ++x)
-                    for (int y = 0; y < n; ++y)
-                    {
-                        int dx = DXS[k], dy = DYS[k], g;
-                        if (cross)
+            {
+                int dx = DXS[k], dy = DYS[k];
+                if (cross)
+                {
+                    // the tip that appears ahead, plus the arm laid across the
+                    // direction of travel; the cell itself was already in view
+                    // before the step
+                    add_edge(e, k, cx - dx * r, cy - dy * r, dl, db);
+                    for (int j = -r; j <= r; ++j)
+                        if (j != 0)
                         {
-                            // the tip that appears ahead, plus the arm laid
-                            // across the direction of travel; the cell itself
-                            // was already in view before the step
-                            int px = x + dx * r, py = y + dy * r;
-                            int tip = in_map(px, py) ? obs_mass[idx(px, py)] : 0;
-                            int arm = dx != 0 ? colsum(pc, x, y - r, y + r)
-                                              : rowsum(pr, y, x - r, x + r);
-                            g = tip + arm - obs_mass[idx(x, y)];
+                            if (dx != 0)
+                                add_edge(e, k, cx, cy + j, dl, db);
+                            else
+                                add_edge(e, k, cx + j, cy, dl, db);
                         }
+                }
+                else
+                {
+                    // the leading row or column of the square
+                    for (int j = -r; j <= r; ++j)
+                    {
+                        if (dx != 0)
+                            add_edge(e, k, cx - dx * r, cy + j, dl, db);
                         else
-                        {
-                            g = dx != 0 ? colsum(pc, x + dx * r, y - r, y + r)
-                                        : rowsum(pr, y + dy * r, x - r, x + r);
-                        }
-                        edge_val[ty][k * n * n + idx(x, y)] = g < 0 ? 0 : g;
+                            add_edge(e, k, cx + j, cy - dy * r, dl, db);
                     }
+                }
+            }
         }
     }
-
-    int colsum(const vector<int> &pc, int x, int a, int b) const
+    void add_edge(EdgeVal &e, int k, int x, int y, int dl, int db)
     {
-        if (x < 0 || x >= n)
-            return 0;
-        if (a < 0)
-            a = 0;
-        if (b > n - 1)
-            b = n - 1;
-        if (a > b)
-            return 0;
-        return pc[x * (n + 1) + b + 1] - pc[x * (n + 1) + a];
-    }
-    int rowsum(const vector<int> &pr, int y, int a, int b) const
-    {
-        if (y < 0 || y >= n)
-            return 0;
-        if (a < 0)
-            a = 0;
-        if (b > n - 1)
-            b = n - 1;
-        if (a > b)
-            return 0;
-        return pr[y * (n + 1) + b + 1] - pr[y * (n + 1) + a];
+        if (!in_map(x, y))
+            return;
+        int i = k * n * n + idx(x, y);
+        e.live[i] += dl;
+        e.base[i] += db;
     }
+
+    // Exact-plan solver and its inputs, kept across ticks for their buffers;
+    // the pool is started on first use when SCHED_T_THREADS > 1.  A copied
+    // scheduler starts its own solver and pool.
+    Fresh<ExactPlanner> exact;
+    vector<ExactPlanner::Worker> exact_workers;
+    Fresh<unique_ptr<ThreadPool>> pool;
+    // Anytime mode: the tick's planning budget (-1 = SCHED_T_DEADLINE), and
+    // the smallest free-task count whose exact plan ran past it, as of tick
+    // exact_blown_at.  Sets that large go straight to the local search, which
+    // always has a plan -- until EXACT_REPROBE ticks later, when the exact
+    // plan is tried again, so one slow tick (a cold start, a busy CPU) does
+    // not ban it for the rest of the run.
+    long long tick_budget_us = -1;
+    int exact_blown = PLAN_INF;
+    int exact_blown_at = -1;
 };
 
 Scheduler::Scheduler() : s_(new State()) {}
+// A copy plans for another map's robots: its robot table is rebuilt on the
+// next tick.
+Scheduler::Scheduler(const Scheduler &other) : s_(new State(*other.s_)) { s_->by_id.clear(); }
+Scheduler &Scheduler::operator=(const Scheduler &other)
+{
+    if (this != &other)
+    {
+        *s_ = *other.s_;
+        s_->by_id.clear();
+    }
+    return *this;
+}
 Scheduler::~Scheduler() {}
 
-void Scheduler::on_info_updated(const set<Coord> &observed_coords,
-                                const set<Coord> &updated_coords,
-                                const vector<vector<vector<int>>> &known_cost_map,
-                                const vector<vector<OBJECT>> &known_object_map,
+void Scheduler::set_tick_budget(long long microseconds)
+{
+    s_->tick_budget_us = microseconds;
+    s_->exact_blown = PLAN_INF; // measured against the old budget
+}
+
+const TickProfile &Scheduler::profile() const { return s_->prof; }
+
+void Scheduler::on_delta(const MAP_DELTA &delta)
+{
+    State &st = *s_;
+    st.delta_fed = true;
+    st.delta_revealed.insert(st.delta_revealed.end(), delta.revealed.begin(), delta.revealed.end());
+    st.delta_tasks.insert(st.delta_tasks.end(), delta.tasks.begin(), delta.tasks.end());
+    st.delta_robots.insert(st.delta_robots.end(), delta.robots.begin(), delta.robots.end());
+}
+
+// Rebuilds the event-kept tables from the lists, as a tick without a delta
+// has to.
+void Scheduler::State::seed_events(const vector<shared_ptr<TASK>> &active_tasks,
+                                   const vector<shared_ptr<ROBOT>> &robots)
+{
+    max_id = 0;
+    for (size_t i = 0; i < robots.size(); ++i)
+        max_id = max(max_id, robots[i]->id);
+    num_robots = robots.size();
+    if (static_cast<int>(assigned.size()) < max_id + 1)
+    {
+        init_energy.resize(max_id + 1, -1);
+        assigned.resize(max_id + 1, -1);
+        next_step.resize(max_id + 1, Coord(-1, -1));
+        dist.resize(max_id + 1);
+        par.resize(max_id + 1);
+        dist_c.resize(max_id + 1);
+        field.resize(max_id + 1);
+        field_c.resize(max_id + 1);
+    }
+    by_id.assign(max_id + 1, static_cast<const ROBOT *>(0));
+    live.clear();
+    act_ids.clear();
+    fill(act_pos.begin(), act_pos.end(), -1);
+    fill(worked_by.begin(), worked_by.end(), -1);
+    for (size_t i = 0; i < robots.size(); ++i)
+    {
+        const ROBOT &r = *robots[i];
+        by_id[r.id] = &r;
+        if (init_energy[r.id] < 0)
+            init_energy[r.id] = r.get_energy();
+        next_step[r.id] = r.get_coord();
+        if (r.get_status() == ROBOT::STATUS::EXHAUSTED || r.get_energy() <= 0)
+            continue;
+        live.push_back(r.id);
+        if (r.get_status() == ROBOT::STATUS::WORKING && r.get_assigned_task_id() >= 0)
+        {
+            track_task(r.get_assigned_task_id());
+            worked_by[r.get_assigned_task_id()] = r.id;
+        }
+    }
+    for (size_t i = 0; i < active_tasks.size(); ++i)
+    {
+        const TASK &t = *active_tasks[i];
+        track_task(t.id);
+        act_pos[t.id] = static_cast<int>(act_ids.size());
+        act_ids.push_back(t.id);
+        worked_by[t.id] = t.get_assigned_robot_id();
+        if (!t.is_done())
+            first_seen.insert(make_pair(t.id, now));
+    }
+    events_synced = delta_fed;
+    tasks_changed = true;
+}
+
+// Replays the events fed since the last tick; false when the result no longer
+// matches the map (the caller then seeds from scratch).
+bool Scheduler::State::apply_events(size_t num_active)
+{
+    for (size_t i = 0; i < delta_tasks.size(); ++i)
+    {
+        const MAP_DELTA::TASK_CHANGE &c = delta_tasks[i];
+        track_task(c.id);
+        if (c.kind == MAP_DELTA::TASK_CHANGE::DISCOVERED)
+        {
+            if (act_pos[c.id] >= 0)
+                return false;
+            act_pos[c.id] = static_cast<int>(act_ids.size());
+            act_ids.push_back(c.id);
+            first_seen.insert(make_pair(c.id, now));
+        }
+        else
+        {
+            int pos = act_pos[c.id];
+            if (pos < 0)
+                return false;
+            act_ids[pos] = act_ids.back();
+            act_pos[act_ids[pos]] = pos;
+            act_ids.pop_back();
+            act_pos[c.id] = -1;
+        }
+        tasks_changed = true;
+    }
+    for (size_t i = 0; i < delta_robots.size(); ++i)
+    {
+        const MAP_DELTA::ROBOT_CHANGE &c = delta_robots[i];
+        if (c.to == ROBOT::STATUS::WORKING && c.from != ROBOT::STATUS::WORKING)
+        {
+            track_task(c.task);
+            worked_by[c.task] = c.id;
+            tasks_changed = true;
+        }
+        else if (c.from == ROBOT::STATUS::WORKING && c.to != ROBOT::STATUS::WORKING && c.task >= 0)
+        {
+            worked_by[c.task] = -1;
+            tasks_changed = true;
+        }
+        if (c.to == ROBOT::STATUS::EXHAUSTED)
+        {
+            live.erase(remove(live.begin(), live.end(), c.id), live.end());
+            next_step[c.id] = c.to_coord; // holds for good
+        }
+    }
+    return act_ids.size() == num_active;
+}
+
+// The tasks free to plan, in active_tasks order; false when the mirror does
+// not line up with active_tasks.
+bool Scheduler::State::free_tasks(const vector<shared_ptr<TASK>> &active_tasks, vector<const TASK *> &tasks)
+{
+    if (tasks_changed)
+    {
+        free_at.clear();
+        for (size_t i = 0; i < act_ids.size(); ++i)
+            if (worked_by[act_ids[i]] == -1) // not physically being worked on
+                free_at.push_back(static_cast<int>(i));
+    }
+    tasks.clear();
+    for (size_t i = 0; i < free_at.size(); ++i)
+    {
+        const TASK *t = active_tasks[free_at[i]].get();
+        if (t->id != act_ids[free_at[i]])
+            return false;
+        if (!t->is_done())
+            tasks.push_back(t);
+    }
+    return true;
+}
+
+void Scheduler::on_info_updated(const CELL_BITMAP &observed_coords,
+                                const CELL_BITMAP &updated_coords,
+                                const GRID_VIEW<int> &known_cost_map,
+                                const GRID_VIEW<OBJECT> &known_object_map,
                                 const vector<shared_ptr<TASK>> &active_tasks,
                                 const vector<shared_ptr<ROBOT>> &robots)
 {
     State &st = *s_;
     load_tunables();
+    const Deadline deadline(st.tick_budget_us >= 0 ? st.tick_budget_us : PLAN_DEADLINE_US);
     ++st.now;
-    st.cost_map = &known_cost_map;
-    st.obj_map = &known_object_map;
-    st.task_dist_cache.clear();
+    st.cost_map = known_cost_map;
+    st.obj_map = known_object_map;
+    st.prof.start();
 
     // ---- lazy init --------------------------------------------------------
     if (st.n == 0)
     {
         st.n = static_cast<int>(known_object_map.size());
         st.last_seen.assign(st.n, vector<int>(st.n, -1));
-    }
-    int max_id = 0;
-    for (size_t i = 0; i < robots.size(); ++i)
-        max_id = max(max_id, robots[i]->id);
-    if (static_cast<int>(st.assigned.size()) < max_id + 1)
-    {
-        st.init_energy.resize(max_id + 1, -1);
-        st.assigned.resize(max_id + 1, -1);
-        st.next_step.resize(max_id + 1, Coord(-1, -1));
-        st.dist.resize(max_id + 1);
-        st.par.resize(max_id + 1);
-        st.dist_c.resize(max_id + 1);
+        st.regions_per_row = (st.n + State::REGION - 1) / State::REGION;
+        st.region_version.assign(st.regions_per_row * st.regions_per_row, 0);
+        st.cell_version.assign(st.n * st.n, 0);
     }
 
     // ---- info update ------------------------------------------------------
-    for (set<Coord>::const_iterator it = observed_coords.begin(); it != observed_coords.end(); ++it)
-        st.last_seen[it->x][it->y] = st.now;
+    for (const Coord c : observed_coords)
+        st.last_seen[c.x][c.y] = st.now;
+    st.cost_changed.clear();
+    for (const Coord c : updated_coords)
+        st.cost_changed.push_back(st.idx(c));
+    st.bump_versions(st.cost_changed);
 
     if (st.drone_cost < 0)
     {
-        for (int x = 0; x < st.n && st.drone_cost < 0; ++x)
-            for (int y = 0; y < st.n; ++y)
-            {
-                int c = known_cost_map[x][y][0];
-                if (c >= 0 && c != INFINITE)
-                {
-                    st.drone_cost = c;
-                    break;
-                }
-            }
+        // The drone cost is uniform: the first known cell gives it, and after
+        // the first tick a delta says which cells can newly be that cell.
+        int c = -1;
+        if (st.delta_fed && st.now > 0)
+        {
+            for (size_t i = 0; i < st.delta_revealed.size() && !(c >= 0 && c != INFINITE); ++i)
+                c = known_cost_map.at(st.delta_revealed[i].x, st.delta_revealed[i].y, 0);
+        }
+        else
+        {
+            for (int x = 0; x < st.n && !(c >= 0 && c != INFINITE); ++x)
+                for (int y = 0; y < st.n && !(c >= 0 && c != INFINITE); ++y)
+                    c = known_cost_map.at(x, y, 0);
+        }
+        if (c >= 0 && c != INFINITE)
+        {
+            st.drone_cost = c;
+            ++st.field_epoch; // every unknown drone cell's estimate moved
+        }
     }
 
+    st.update_step_caps();
+
     // ---- task snapshot (before pathfinding: paths are magnetized) ---------
+    // Fed a delta, the snapshot and the robot tables follow its events and
+    // are only rebuilt where a task was found, finished, started or dropped.
     vector<const TASK *> tasks;
-    st.magnet.assign(st.n * st.n, 0);
-    for (size_t i = 0; i < active_tasks.size(); ++i)
+    if (!(st.delta_fed && st.events_synced && !st.by_id.empty() && robots.size() == st.num_robots &&
+          st.apply_events(active_tasks.size()) && st.free_tasks(active_tasks, tasks)))
     {
-        const TASK *t = active_tasks[i].get();
-        if (t == 0 || t->is_done())
-            continue;
-        if (st.first_seen.find(t->id) == st.first_seen.end())
-            st.first_seen[t->id] = st.now;
-        if (t->get_assigned_robot_id() != -1) // physically being worked on
-            continue;
-        tasks.push_back(t);
-        st.magnet[st.idx(t->coord)] = 1;
+        st.seed_events(active_tasks, robots);
+        st.free_tasks(active_tasks, tasks);
+    }
+    const int max_id = st.max_id;
+    const vector<const ROBOT *> &by_id = st.by_id;
+    st.route_changed = st.cost_changed;
+    if (st.tasks_changed)
+    {
+        vector<int> magnet_cells;
+        for (size_t i = 0; i < tasks.size(); ++i)
+            magnet_cells.push_back(st.idx(tasks[i]->coord));
+        sort(magnet_cells.begin(), magnet_cells.end());
+        if (static_cast<int>(st.magnet.size()) != st.n * st.n)
+            st.magnet.assign(st.n * st.n, 0); // first tick: nothing flipped
+        else
+            set_symmetric_difference(st.magnet_cells.begin(), st.magnet_cells.end(), magnet_cells.begin(),
+                                     magnet_cells.end(), back_inserter(st.route_changed));
+        for (size_t i = 0; i < st.magnet_cells.size(); ++i)
+            st.magnet[st.magnet_cells[i]] = 0;
+        for (size_t i = 0; i < magnet_cells.size(); ++i)
+            st.magnet[magnet_cells[i]] = 1;
+        st.magnet_cells.swap(magnet_cells);
+
+        // task maps persist only while their task is free to be planned
+        vector<int> live;
+        for (size_t i = 0; i < tasks.size(); ++i)
+            live.push_back(tasks[i]->id);
+        sort(live.begin(), live.end());
+        st.evict_task_fields(live);
+        st.tasks_changed = false;
     }
+    st.delta_fed = false;
+    st.delta_revealed.clear();
+    st.delta_tasks.clear();
+    st.delta_robots.clear();
+
+    st.prof.lap(TickProfile::UPDATE);
 
     // ---- per-robot dijkstra ----------------------------------------------
     // Built first so the routed paths below can be tie-broken by it.
-    if (PATH_TIEBREAK)
-    {
-        st.build_obs_mass();
-        st.build_edge_val();
-    }
-    vector<const ROBOT *> by_id(max_id + 1, static_cast<const ROBOT *>(0));
-    for (size_t i = 0; i < robots.size(); ++i)
+    st.update_obs_field(observed_coords, PATH_TIEBREAK != 0);
+    st.prof.lap(TickProfile::EDGE_VAL);
+    for (size_t i = 0; i < st.live.size();)
     {
-        const ROBOT &r = *robots[i];
-        by_id[r.id] = &r;
-        if (st.init_energy[r.id] < 0)
-            st.init_energy[r.id] = r.get_energy();
+        const ROBOT &r = *by_id[st.live[i]];
         st.next_step[r.id] = r.get_coord(); // default: hold
         if (r.get_status() == ROBOT::STATUS::EXHAUSTED || r.get_energy() <= 0)
+        {
+            st.live.erase(st.live.begin() + i); // out of energy for good
             continue;
+        }
+        ++i;
         Coord pos = (r.get_status() == ROBOT::STATUS::MOVING) ? r.get_target_coord() : r.get_coord();
-        st.dijkstra(pos, static_cast<int>(r.type), st.dist[r.id], st.par[r.id], true,
-                    PATH_TIEBREAK ? &st.edge_val[static_cast<int>(r.type)] : 0);
+        st.refresh_field(st.field[r.id], pos, static_cast<int>(r.type), st.dist[r.id], &st.par[r.id], true,
+                         PATH_TIEBREAK ? &st.edge_val[static_cast<int>(r.type)] : 0);
         if (r.type != ROBOT::TYPE::DRONE)
-            st.dijkstra(pos, static_cast<int>(r.type), st.dist_c[r.id], st.scratch_par, false);
+            st.refresh_field(st.field_c[r.id], pos, static_cast<int>(r.type), st.dist_c[r.id], 0, false, 0);
         else
             st.dist_c[r.id] = st.dist[r.id];
     }
 
+    st.prof.lap(TickProfile::ROBOT_DIJKSTRA);
+
     // ---- worker/task matching --------------------------------------------
     // For each task, count workers (including currently-working ones) that can
     // afford it at all.  A task with exactly one possible server skips the
@@ -805,33 +1682,139 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
     leg.pw = &pw;
 
     // A route is feasible when every stop is paid for in energy and finished
-    // before the run ends; e_out receives its total energy.
+    // before the run ends.  Both running totals only ever grow along a route,
+    // so that is the same as every leg being finite and the two totals fitting
+    // at the end -- which lets a route be costed once into a RouteCache and
+    // every insertion, removal or reversal be checked against it in O(1)
+    // (the usual VRP concatenation trick) without building the trial route.
+    struct RouteCache
+    {
+        vector<int> stop;     // energy of stop i: the leg into it plus its work
+        vector<int> back;     // back[i]: stop energy of seq[i] entered from seq[i + 1]
+        vector<int> back_e;   // prefix sums of back: energy,
+        vector<int> back_t;   // ticks,
+        vector<int> back_inf; // and number of unreachable legs
+        int e = 0, t = 0;     // route totals (t in ticks, from now + t0)
+        bool ok = false;
+    };
     struct Eval
     {
         const Leg *leg;
         const vector<const TASK *> *tasks;
         const vector<PW> *pw;
         int now, horizon;
-        bool operator()(size_t k, const vector<int> &seq, int *e_out) const
+        // energy of stop j entered from `from` (PLAN_INF if impossible)
+        int stop(size_t k, int from, int j) const
+        {
+            int trav = (*leg)(k, from, j);
+            int we = work_energy(*(*tasks)[j], static_cast<ROBOT::TYPE>((*pw)[k].type));
+            return (trav >= PLAN_INF || we >= PLAN_INF) ? PLAN_INF : trav + we;
+        }
+        bool fits(size_t k, int e, int t) const
+        {
+            return e <= (*pw)[k].energy && now + (*pw)[k].t0 + t <= horizon - PLAN_SLACK;
+        }
+        void build(size_t k, const vector<int> &seq, RouteCache &rc) const
         {
-            const PW &p = (*pw)[k];
-            int e = 0, t = now + p.t0, prev = -1;
-            int budget = p.energy;
-            for (size_t i = 0; i < seq.size(); ++i)
+            const size_t L = seq.size();
+            rc.stop.resize(L);
+            rc.back.resize(L);
+            rc.back_e.resize(L + 1);
+            rc.back_t.resize(L + 1);
+            rc.back_inf.resize(L + 1);
+            rc.e = rc.t = 0;
+            rc.ok = true;
+            rc.back_e[0] = rc.back_t[0] = rc.back_inf[0] = 0;
+            for (size_t i = 0; i < L; ++i)
             {
-                int j = seq[i];
-                int trav = (*leg)(k, prev, j);
-                if (trav >= PLAN_INF)
+                int c = stop(k, i ? seq[i - 1] : -1, seq[i]);
+                rc.stop[i] = c;
+                if (c >= PLAN_INF)
+                    rc.ok = false;
+                else
+                {
+                    rc.e += c;
+                    rc.t += c / 10;
+                }
+                int b = (i + 1 < L) ? stop(k, seq[i + 1], seq[i]) : 0;
+                rc.back[i] = b;
+                bool inf = b >= PLAN_INF;
+                rc.back_e[i + 1] = rc.back_e[i] + (inf ? 0 : b);
+                rc.back_t[i + 1] = rc.back_t[i] + (inf ? 0 : b / 10);
+                rc.back_inf[i + 1] = rc.back_inf[i] + (inf ? 1 : 0);
+            }
+            if (rc.ok && L > 0)
+                rc.ok = fits(k, rc.e, rc.t);
+        }
+        // seq (costed in rc, which must be ok) with task j inserted before position p
+        bool insert(size_t k, const vector<int> &seq, const RouteCache &rc, size_t p, int j,
+                    int *e_out) const
+        {
+            int a = stop(k, p ? seq[p - 1] : -1, j);
+            if (a >= PLAN_INF)
+                return false;
+            int e = rc.e + a, t = rc.t + a / 10;
+            if (p < seq.size())
+            {
+                int b = stop(k, j, seq[p]);
+                if (b >= PLAN_INF)
                     return false;
-                int we = work_energy(*(*tasks)[j], static_cast<ROBOT::TYPE>(p.type));
-                if (we >= PLAN_INF || e + trav + we > budget)
+                e += b - rc.stop[p];
+                t += b / 10 - rc.stop[p] / 10;
+            }
+            if (!fits(k, e, t))
+                return false;
+            if (e_out)
+                *e_out = e;
+            return true;
+        }
+        // seq with the stop at position i removed
+        bool remove(size_t k, const vector<int> &seq, const RouteCache &rc, size_t i,
+                    int *e_out) const
+        {
+            int e = rc.e - rc.stop[i], t = rc.t - rc.stop[i] / 10;
+            if (i + 1 < seq.size())
+            {
+                int b = stop(k, i ? seq[i - 1] : -1, seq[i + 1]);
+                if (b >= PLAN_INF)
                     return false;
-                t += (trav + we) / 10;
-                if (t > horizon - PLAN_SLACK)
+                e += b - rc.stop[i + 1];
+                t += b / 10 - rc.stop[i + 1] / 10;
+            }
+            if (seq.size() > 1 && !fits(k, e, t))
+                return false;
+            if (e_out)
+                *e_out = e;
+            return true;
+        }
+        // seq with positions a..b (a < b) walked in reverse
+        bool reverse(size_t k, const vector<int> &seq, const RouteCache &rc, size_t a, size_t b,
+                     int *e_out) const
+        {
+            if (rc.back_inf[b] - rc.back_inf[a] > 0)
+                return false;
+            int first = stop(k, a ? seq[a - 1] : -1, seq[b]);
+            if (first >= PLAN_INF)
+                return false;
+            int e = rc.e, t = rc.t;
+            size_t hi = min(b + 1, seq.size() - 1);
+            for (size_t q = a; q <= hi; ++q)
+            {
+                e -= rc.stop[q];
+                t -= rc.stop[q] / 10;
+            }
+            e += first + rc.back_e[b] - rc.back_e[a];
+            t += first / 10 + rc.back_t[b] - rc.back_t[a];
+            if (b + 1 < seq.size())
+            {
+                int last = stop(k, seq[a], seq[b + 1]);
+                if (last >= PLAN_INF)
                     return false;
-                e += trav + we;
-                prev = j;
+                e += last;
+                t += last / 10;
             }
+            if (!fits(k, e, t))
+                return false;
             if (e_out)
                 *e_out = e;
             return true;
@@ -843,161 +1826,86 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
     ok.pw = &pw;
     ok.now = st.now;
     ok.horizon = horizon_t;
+    vector<RouteCache> cache(pw.size());
+    RouteCache empty_rc;
+    const vector<int> no_route;
+    ok.build(0, no_route, empty_rc);
+
+    st.prof.lap(TickProfile::SERVER_COUNT);
 
     // ---- exact plan, when the known task set is small enough ---------------
     // The local search below is insertion + relocate/swap/2-opt, and measured
     // offline against a subset-DP solver it lands ~1.1 tasks short of the true
-    // optimum.  With few enough free tasks the optimum is directly computable:
-    // for each worker, a DP over (subset, last visited) carrying the Pareto
-    // frontier of (energy, completion time) -- the two are not interchangeable,
-    // because waiting for a task to be reachable costs time but no energy --
-    // then a subset partition across workers maximising the count and breaking
-    // ties on total energy.
+    // optimum.  With few enough free tasks the optimum is directly computable
+    // (exact_plan.h): a per-worker Pareto DP over (subset, last visited), then
+    // a subset partition across workers maximising the count and breaking
+    // ties on total energy.  Both phases spread over st.pool when
+    // SCHED_T_THREADS asks for one, with the same plan as a serial run.
+    // Under a deadline a solve that runs out of time is dropped and the tick
+    // falls through to the local search.
     bool exact_done = false;
     if (EXACT_MAX > 0 && !tasks.empty() && static_cast<int>(tasks.size()) <= EXACT_MAX &&
-        pw.size() <= 6)
+        pw.size() <= 6 &&
+        (static_cast<int>(tasks.size()) < st.exact_blown || st.now - st.exact_blown_at >= EXACT_REPROBE))
     {
         const int nfree = static_cast<int>(tasks.size());
-        const int FULL = 1 << nfree;
-        // per worker: best[S] = minimal energy to serve exactly S (PLAN_INF = can't)
-        vector<vector<int>> bestE(pw.size(), vector<int>(FULL, PLAN_INF));
-        // pareto[S * nfree + last] = frontier of (energy, finish tick)
-        vector<vector<pair<int, int> > > par;
+        vector<ExactPlanner::Worker> &ew = st.exact_workers;
+        ew.resize(pw.size());
         for (size_t k = 0; k < pw.size(); ++k)
         {
-            par.assign(static_cast<size_t>(FULL) * nfree, vector<pair<int, int> >());
-            for (int j = 0; j < nfree; ++j)
+            ew[k].energy = pw[k].energy;
+            ew[k].horizon = horizon_t - PLAN_SLACK;
+            ew[k].leg.resize(static_cast<size_t>(nfree) * nfree);
+            ew[k].work.resize(nfree);
+            ew[k].first.resize(nfree);
+            for (int a = 0; a < nfree; ++a)
             {
-                vector<int> one(1, j);
+                ew[k].work[a] = work_energy(*tasks[a], static_cast<ROBOT::TYPE>(pw[k].type));
+                for (int b = 0; b < nfree; ++b)
+                    ew[k].leg[a * nfree + b] = (a == b) ? PLAN_INF : leg(k, a, b);
                 int e = 0;
-                if (!ok(k, one, &e))
-                    continue;
-                par[static_cast<size_t>(1 << j) * nfree + j].push_back(
-                    make_pair(e, st.now + pw[k].t0 + e / 10));
-                if (e < bestE[k][1 << j])
-                    bestE[k][1 << j] = e;
+                if (ok.insert(k, no_route, empty_rc, 0, a, &e))
+                    ew[k].first[a] = make_pair(e, st.now + pw[k].t0 + e / 10);
+                else
+                    ew[k].first[a] = make_pair(PLAN_INF, 0);
             }
-            for (int S = 1; S < FULL; ++S)
-                for (int last = 0; last < nfree; ++last)
-                {
-                    if (!((S >> last) & 1))
-                        continue;
-                    const vector<pair<int, int> > cur = par[static_cast<size_t>(S) * nfree + last];
-                    if (cur.empty())
-                        continue;
-                    for (int j = 0; j < nfree; ++j)
-                    {
-                        if ((S >> j) & 1)
-                            continue;
-                        int legc = leg(k, last, j);
-                        int we = work_energy(*tasks[j], static_cast<ROBOT::TYPE>(pw[k].type));
-                        if (legc >= PLAN_INF || we >= PLAN_INF)
-                            continue;
-                        int S2 = S | (1 << j);
-                        for (size_t c = 0; c < cur.size(); ++c)
-                        {
-                            int e = cur[c].first + legc + we;
-                            if (e > pw[k].energy)
-                                continue;
-                            int t = cur[c].second + (legc + we) / 10;
-                            if (t > horizon_t - PLAN_SLACK)
-                                continue;
-                            // dominance prune
-                            vector<pair<int, int> > &v = par[static_cast<size_t>(S2) * nfree + j];
-                            bool dom = false;
-                            for (size_t q = 0; q < v.size() && !dom; ++q)
-                                if (v[q].first <= e && v[q].second <= t)
-                                    dom = true;
-                            if (dom)
-                                continue;
-                            for (size_t q = 0; q < v.size();)
-                            {
-                                if (v[q].first >= e && v[q].second >= t)
-                                    v.erase(v.begin() + q);
-                                else
-                                    ++q;
-                            }
-                            v.push_back(make_pair(e, t));
-                            if (e < bestE[k][S2])
-                                bestE[k][S2] = e;
-                        }
-                    }
-                }
         }
-        // partition: maximise served count, tie-break on total energy
-        const int NEG = -1;
-        vector<int> cnt(FULL, NEG), eng(FULL, PLAN_INF);
-        vector<int> pick(static_cast<size_t>(FULL) * pw.size(), 0);
-        cnt[0] = 0;
-        eng[0] = 0;
-        for (size_t k = 0; k < pw.size(); ++k)
+        if (!*st.pool && PLAN_THREADS > 1)
+            st.pool->reset(new ThreadPool(PLAN_THREADS));
+        exact_done = st.exact->solve(nfree, ew, nullptr, false, st.pool->get(), deadline);
+        st.prof.add(TickProfile::EXACT_STATES, st.exact->states());
+        if (!exact_done)
         {
-            vector<int> ncnt(FULL, NEG), neng(FULL, PLAN_INF);
-            vector<int> npick(pick.size(), 0);
-            for (int S = 0; S < FULL; ++S)
-            {
-                if (cnt[S] < 0)
-                    continue;
-                {   // worker k serves nothing and stays where it is
-                    int e2 = eng[S];
-                    if (cnt[S] > ncnt[S] || (cnt[S] == ncnt[S] && e2 < neng[S]))
-                    {
-                        ncnt[S] = cnt[S];
-                        neng[S] = e2;
-                        for (size_t q = 0; q < pw.size(); ++q)
-                            npick[static_cast<size_t>(S) * pw.size() + q] =
-                                pick[static_cast<size_t>(S) * pw.size() + q];
-                        npick[static_cast<size_t>(S) * pw.size() + k] = 0;
-                    }
-                }
-                int rest = (FULL - 1) & ~S;
-                for (int T = rest; T; T = (T - 1) & rest)
-                {
-                    if (bestE[k][T] >= PLAN_INF)
-                        continue;
-                    int c2 = cnt[S] + __builtin_popcount(T);
-                    int e2 = eng[S] + bestE[k][T];
-                    int U = S | T;
-                    if (c2 > ncnt[U] || (c2 == ncnt[U] && e2 < neng[U]))
-                    {
-                        ncnt[U] = c2;
-                        neng[U] = e2;
-                        for (size_t q = 0; q < pw.size(); ++q)
-                            npick[static_cast<size_t>(U) * pw.size() + q] =
-                                pick[static_cast<size_t>(S) * pw.size() + q];
-                        npick[static_cast<size_t>(U) * pw.size() + k] = T;
-                    }
-                }
-            }
-            cnt.swap(ncnt);
-            eng.swap(neng);
-            pick.swap(npick);
-        }
-        int bestS = 0;
-        for (int S = 0; S < FULL; ++S)
-            if (cnt[S] > cnt[bestS] || (cnt[S] == cnt[bestS] && eng[S] < eng[bestS]))
-                bestS = S;
+            st.exact_blown = nfree;
+            st.exact_blown_at = st.now;
+        }
+        else if (nfree >= st.exact_blown)
+            st.exact_blown = PLAN_INF; // the re-probe fitted: lift the ban
+    }
+    if (exact_done)
+    {
+        const int nfree = static_cast<int>(tasks.size());
+        const vector<int> &pick = st.exact->pick();
         // reconstruct each worker's order over its assigned subset, greedily by
         // cheapest feasible extension (subsets are small; verified by ok())
         for (size_t k = 0; k < pw.size(); ++k)
         {
-            int T = pick[static_cast<size_t>(bestS) * pw.size() + k];
+            int T = pick[k];
             route[k].clear();
             while (T)
             {
                 int bj = -1, be = PLAN_INF;
+                ok.build(k, route[k], cache[k]);
                 for (int j = 0; j < nfree; ++j)
                 {
                     if (!((T >> j) & 1))
                         continue;
-                    vector<int> trial = route[k];
-                    trial.push_back(j);
                     int rest = T & ~(1 << j);
                     // must stay completable: append the rest in any feasible order
                     int e = 0;
-                    if (!ok(k, trial, &e))
+                    if (!cache[k].ok || !ok.insert(k, route[k], cache[k], route[k].size(), j, &e))
                         continue;
-                    if (rest && bestE[k][T] >= PLAN_INF)
+                    if (rest && st.exact->best_energy(k, T) >= PLAN_INF)
                         continue;
                     if (e < be)
                     {
@@ -1011,9 +1919,10 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
                 T &= ~(1 << bj);
             }
         }
-        exact_done = true;
     }
 
+    st.prof.lap(TickProfile::EXACT_DP);
+
     vector<char> placed(tasks.size(), 0);
     if (!exact_done)
     {
@@ -1032,11 +1941,10 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
                 map<int, int>::iterator f = id_to_idx.find(it->second[q]);
                 if (f == id_to_idx.end() || placed[f->second])
                     continue;
-                vector<int> trial = route[k];
-                trial.push_back(f->second);
-                if (!ok(k, trial, 0))
+                ok.build(k, route[k], cache[k]);
+                if (!cache[k].ok || !ok.insert(k, route[k], cache[k], route[k].size(), f->second, 0))
                     continue;
-                route[k].swap(trial);
+                route[k].push_back(f->second);
                 placed[f->second] = 1;
             }
         }
@@ -1046,26 +1954,27 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
         for (size_t q = 0; q < route[k].size(); ++q)
             placed[route[k][q]] = 1;
 
-    // insertion: repeatedly take the globally cheapest feasible placement
-    for (; !exact_done;)
+    // insertion: repeatedly take the globally cheapest feasible placement.
+    // The seeded routes are feasible on their own, so running out of time
+    // here only leaves tasks unplanned for this tick.
+    for (; !exact_done && !deadline.passed();)
     {
         int best_inc = PLAN_INF, bj = -1, bp = -1;
         size_t bk = 0;
         for (size_t k = 0; k < pw.size(); ++k)
         {
-            int e0 = 0;
-            if (!ok(k, route[k], &e0))
+            ok.build(k, route[k], cache[k]);
+            if (!cache[k].ok)
                 continue;
+            int e0 = cache[k].e;
             for (size_t j = 0; j < tasks.size(); ++j)
             {
                 if (placed[j])
                     continue;
                 for (size_t p = 0; p <= route[k].size(); ++p)
                 {
-                    vector<int> trial = route[k];
-                    trial.insert(trial.begin() + p, static_cast<int>(j));
                     int e1 = 0;
-                    if (!ok(k, trial, &e1))
+                    if (!ok.insert(k, route[k], cache[k], p, static_cast<int>(j), &e1))
                         continue;
                     if (e1 - e0 < best_inc)
                     {
@@ -1083,44 +1992,53 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
         placed[bj] = 1;
     }
 
-    // local search: cheaper routes free the energy that lets one more task fit
-    for (int iter = 0; iter < PLAN_ITERS && !exact_done; ++iter)
+    st.prof.lap(TickProfile::INSERTION);
+
+    // local search: cheaper routes free the energy that lets one more task fit.
+    // Under a deadline it runs to a local optimum or until time is up instead
+    // of PLAN_ITERS rounds; the routes it leaves seed the next tick, which is
+    // where an interrupted search picks up again.
+    vector<int> src;
+    RouteCache src_rc;
+    for (int iter = 0; (deadline.enabled() || iter < PLAN_ITERS) && !exact_done; ++iter)
     {
+        if (deadline.passed())
+            break;
         bool improved = false;
-        for (size_t k = 0; k < pw.size() && !improved; ++k)
+        for (size_t k = 0; k < pw.size(); ++k)
+            ok.build(k, route[k], cache[k]);
+        for (size_t k = 0; k < pw.size() && !improved && !deadline.passed(); ++k)
             for (size_t i = 0; i < route[k].size() && !improved; ++i)
             {
-                vector<int> src = route[k];
-                int j = src[i];
-                src.erase(src.begin() + i);
-                if (!ok(k, src, 0))
+                int j = route[k][i];
+                if (!cache[k].ok || !ok.remove(k, route[k], cache[k], i, 0))
                     continue;
+                src.assign(route[k].begin(), route[k].end());
+                src.erase(src.begin() + i);
+                ok.build(k, src, src_rc);
                 for (size_t k2 = 0; k2 < pw.size() && !improved; ++k2)
                 {
                     const vector<int> &base = (k2 == k) ? src : route[k2];
+                    const RouteCache &base_rc = (k2 == k) ? src_rc : cache[k2];
+                    if (!base_rc.ok)
+                        continue;
                     for (size_t p = 0; p <= base.size(); ++p)
                     {
                         if (k2 == k && p == i)
                             continue;
-                        vector<int> trial = base;
-                        trial.insert(trial.begin() + p, j);
-                        int before = 0, after = 0, tmp = 0;
-                        if (!ok(k2, trial, &after))
+                        int before = 0, after = 0;
+                        if (!ok.insert(k2, base, base_rc, p, j, &after))
                             continue;
-                        ok(k, route[k], &tmp);
-                        before += tmp;
+                        before += cache[k].ok ? cache[k].e : 0;
                         if (k2 != k)
                         {
-                            ok(k2, route[k2], &tmp);
-                            before += tmp;
-                            ok(k, src, &tmp);
-                            after += tmp;
+                            before += cache[k2].ok ? cache[k2].e : 0;
+                            after += src_rc.ok ? src_rc.e : 0;
                         }
                         if (after < before)
                         {
-                            if (k2 != k)
-                                route[k] = src;
-                            route[k2] = trial;
+                            route[k] = src;
+                            route[k2].insert(route[k2].begin() + p, j);
                             improved = true;
                             break;
                         }
@@ -1131,14 +2049,12 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
             for (size_t a = 0; a + 1 < route[k].size() && !improved; ++a)
                 for (size_t b = a + 1; b < route[k].size(); ++b)
                 {
-                    vector<int> trial = route[k];
-                    reverse(trial.begin() + a, trial.begin() + b + 1);
-                    int e0 = 0, e1 = 0;
-                    if (!ok(k, trial, &e1) || !ok(k, route[k], &e0))
+                    int e0 = cache[k].e, e1 = 0;
+                    if (!cache[k].ok || !ok.reverse(k, route[k], cache[k], a, b, &e1))
                         continue;
                     if (e1 < e0)
                     {
-                        route[k].swap(trial);
+                        std::reverse(route[k].begin() + a, route[k].begin() + b + 1);
                         improved = true;
                         break;
                     }
@@ -1146,24 +2062,27 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
         if (!improved)
             break;
         // room may have opened up for a task nobody could afford before
+        for (size_t k = 0; k < pw.size(); ++k)
+            ok.build(k, route[k], cache[k]);
         for (size_t j = 0; j < tasks.size(); ++j)
         {
             if (placed[j])
                 continue;
             for (size_t k = 0; k < pw.size() && !placed[j]; ++k)
-                for (size_t p = 0; p <= route[k].size(); ++p)
+                for (size_t p = 0; p <= route[k].size() && cache[k].ok; ++p)
                 {
-                    vector<int> trial = route[k];
-                    trial.insert(trial.begin() + p, static_cast<int>(j));
-                    if (!ok(k, trial, 0))
+                    if (!ok.insert(k, route[k], cache[k], p, static_cast<int>(j), 0))
                         continue;
-                    route[k].swap(trial);
+                    route[k].insert(route[k].begin() + p, static_cast<int>(j));
+                    ok.build(k, route[k], cache[k]);
                     placed[j] = 1;
                     break;
                 }
         }
     }
 
+    st.prof.lap(TickProfile::LOCAL_SEARCH);
+
     // ---- hand the first leg of each route to its worker --------------------
     map<int, int> new_owner;
     for (int i = 0; i <= max_id; ++i)
@@ -1204,29 +2123,91 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
     }
 
     st.owner.swap(new_owner);
+    st.prof.lap(TickProfile::HANDOFF);
 
     // serve_dist[c] = cheapest travel energy any worker still able to act could
     // pay to reach c; it is what turns raw observation value into value that
-    // can actually become a completion.
-    st.serve_dist.assign(st.n * st.n, PLAN_INF);
+    // can actually become a completion.  The same pass over the workers'
+    // clean fields keeps the two nearest of them per cell for the patrol.
+    // A large fleet gets both from nearest_workers instead: the nearest worker
+    // that has the energy (at least 1500, and the trip itself) is one of the
+    // two found, except where both fall short; only those cells are resolved
+    // from the fields.
+    vector<const ROBOT *> servers;
     for (size_t i = 0; i < robots.size(); ++i)
     {
         const ROBOT &r = *robots[i];
         if (r.type == ROBOT::TYPE::DRONE || r.get_status() == ROBOT::STATUS::EXHAUSTED)
             continue;
-        if (r.get_energy() < 1500 || st.dist_c[r.id].empty())
-            continue; // nearly-spent workers won't serve new finds
+        if (!st.dist_c[r.id].empty())
+            servers.push_back(&r);
+    }
+    st.serve_dist.assign(st.n * st.n, PLAN_INF);
+    if (static_cast<int>(servers.size()) >= SERVE_MSRC)
+    {
+        st.nearest_workers(servers);
+        auto serves = [&](int id, int dd)
+        { return id >= 0 && by_id[id]->get_energy() >= 1500 && dd <= by_id[id]->get_energy(); };
         for (int c = 0; c < st.n * st.n; ++c)
         {
-            int dd = st.dist_c[r.id][c];
-            if (dd > r.get_energy())
-                dd = PLAN_INF; // beyond its actual reach
-            if (dd < st.serve_dist[c])
-                st.serve_dist[c] = dd;
+            if (st.near1[c] >= PLAN_INF)
+                continue;
+            if (serves(st.near1_id[c], st.near1[c]))
+                st.serve_dist[c] = st.near1[c];
+            else if (st.near2[c] >= PLAN_INF || serves(st.near2_id[c], st.near2[c]))
+                st.serve_dist[c] = st.near2[c];
+            else
+            {
+                for (size_t i = 0; i < servers.size(); ++i)
+                {
+                    const ROBOT &r = *servers[i];
+                    int dd = st.dist_c[r.id][c];
+                    if (r.get_energy() >= 1500 && dd <= r.get_energy() && dd < st.serve_dist[c])
+                        st.serve_dist[c] = dd;
+                }
+            }
         }
     }
+    else
+    {
+        const bool near_field = PATROL_DISPERSE > 0;
+        if (near_field)
+        {
+            st.near1.assign(st.n * st.n, PLAN_INF);
+            st.near2.assign(st.n * st.n, PLAN_INF);
+        }
+        for (size_t i = 0; i < servers.size(); ++i)
+        {
+            const ROBOT &r = *servers[i];
+            const int *dc = st.dist_c[r.id].data();
+            if (near_field)
+            {
+                int *n1 = st.near1.data(), *n2 = st.near2.data();
+                for (int c = 0; c < st.n * st.n; ++c)
+                {
+                    n2[c] = min(n2[c], max(n1[c], dc[c]));
+                    n1[c] = min(n1[c], dc[c]);
+                }
+            }
+            if (r.get_energy() < 1500)
+                continue; // nearly-spent workers won't serve new finds
+            for (int c = 0; c < st.n * st.n; ++c)
+            {
+                int dd = dc[c];
+                if (dd > r.get_energy())
+                    dd = PLAN_INF; // beyond its actual reach
+                if (dd < st.serve_dist[c])
+                    st.serve_dist[c] = dd;
+            }
+        }
+    }
+
+    st.prof.lap(TickProfile::SERVE_DIST);
 
+    // staleness is weighted by serve_dist, so it is built here, but it is
+    // observation-value work and is timed with the other value grids
     st.build_staleness();
+    st.prof.lap(TickProfile::EDGE_VAL);
 
     // ---- drones: committed serpentine sweeps ------------------------------
 
@@ -1316,26 +2297,26 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
         Coord chosen = pos;
         vector<int> pgain;
         if (SCOUT_PATHVAL)
-            st.path_gain(d, st.par[r.id], viewr, false, pgain);
-        for (int x = half.first; x <= half.second; ++x)
-            for (int y = 0; y < st.n; ++y)
+            st.path_gain(st.field[r.id].order, st.par[r.id], viewr, false, pgain);
+        // The band's rows are one contiguous run of cells, scanned in the
+        // same (x, y) order as a nested loop would.
+        if (half.first <= half.second)
+        {
+            int lo = st.idx(half.first, 0), cnt = (half.second - half.first + 1) * st.n;
+            const int *g = SCOUT_PATHVAL ? pgain.data() + lo : 0;
+            if (!SCOUT_PATHVAL)
             {
-                int dd = d[st.idx(x, y)];
-                if (dd >= PLAN_INF || dd > r.get_energy() - DRONE_CAMERA_FLOOR)
-                    continue;
-                if (Coord(x, y) == pos)
-                    continue;
-                int g = SCOUT_PATHVAL ? pgain[st.idx(x, y)]
-                                      : st.window_gain(x, y, viewr, false);
-                if (g <= 0)
-                    continue;
-                int ratio = static_cast<int>(static_cast<long long>(g) * 1000 / (dd + SCOUT_K));
-                if (ratio > best_ratio)
-                {
-                    best_ratio = ratio;
-                    chosen = Coord(x, y);
-                }
+                st.scan_gain.resize(cnt);
+                for (int c = 0; c < cnt; ++c)
+                    st.scan_gain[c] = st.window_gain((lo + c) / st.n, (lo + c) % st.n, viewr, false);
+                g = st.scan_gain.data();
             }
+            int at = -1;
+            RatioArgmax::scan(g, d.data() + lo, cnt, r.get_energy() - DRONE_CAMERA_FLOOR, SCOUT_K,
+                              st.idx(pos) - lo, best_ratio, at);
+            if (at >= 0)
+                chosen = Coord((lo + at) / st.n, (lo + at) % st.n);
+        }
 
         map<int, Coord>::iterator gi = st.drone_goal.find(r.id);
         bool need_new = true;
@@ -1373,8 +2354,7 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
         }
         st.next_step[r.id] = st.first_step(st.par[r.id], pos, st.drone_goal[r.id]);
     }
-
-
+    st.prof.lap(TickProfile::DRONES);
 
     if (true)
     {
@@ -1409,64 +2389,47 @@ void Scheduler::on_info_updated(const set<Coord> &observed_coords,
             Coord best = pos;
             vector<int> pgain;
             if (SCOUT_PATHVAL)
-                st.path_gain(st.dist[r.id], st.par[r.id], viewr, cross, pgain);
-            for (int x = 0; x < st.n; ++x)
-                for (int y = 0; y < st.n; ++y)
+                st.path_gain(st.field[r.id].order, st.par[r.id], viewr, cross, pgain);
+            const int *g = SCOUT_PATHVAL ? pgain.data() : 0;
+            if (!SCOUT_PATHVAL || PATROL_DISPERSE > 0)
+            {
+                st.scan_gain.resize(st.n * st.n);
+                for (int c = 0; c < st.n * st.n; ++c)
                 {
-                    int dd = d[st.idx(x, y)];
-                    if (dd >= PLAN_INF || dd > range || Coord(x, y) == pos)
-                        continue;
-                    int g = SCOUT_PATHVAL ? pgain[st.idx(x, y)]
-                                          : st.window_gain(x, y, viewr, cross);
-                    if (g <= 0)
-                        continue;
-                    if (PATROL_DISPERSE > 0)
+                    int gc = SCOUT_PATHVAL ? pgain[c] : st.window_gain(c / st.n, c % st.n, viewr, cross);
+                    if (gc > 0 && PATROL_DISPERSE > 0)
                     {
                         // A patrol is also a repositioning: standing where no
                         // other worker can cheaply reach shortens the trip to
                         // whatever spawns there next.  Free to steer, since the
                         // move is happening anyway.
-                        int far = PLAN_INF;
-                        for (size_t k = 0; k < robots.size(); ++k)
-                        {
-                            const ROBOT &o = *robots[k];
-                            if (o.id == r.id || o.type == ROBOT::TYPE::DRONE ||
-                                o.get_status() == ROBOT::STATUS::EXHAUSTED ||
-                                st.dist_c[o.id].empty())
-                                continue;
-                            far = min(far, st.dist_c[o.id][st.idx(x, y)]);
-                        }
+                        // Nearest *other* worker: if this one is the
+                        // nearest (or tied for it) the second is the answer.
+                        int far = d[c] == st.near1[c] ? st.near2[c] : st.near1[c];
                         if (far < PLAN_INF)
                         {
                             int b = min(far, 5000) * PATROL_DISPERSE / 5000;
-                            g = static_cast<int>(static_cast<long long>(g) * (1000 + b) / 1000);
+                            gc = static_cast<int>(static_cast<long long>(gc) * (1000 + b) / 1000);
                         }
                     }
-                    int ratio = static_cast<int>(static_cast<long long>(g) * 1000 / (dd + SCOUT_K));
-                    if (ratio > best_ratio)
-                    {
-                        best_ratio = ratio;
-                        best = Coord(x, y);
-                    }
+                    st.scan_gain[c] = gc;
                 }
+                g = st.scan_gain.data();
+            }
+            int at = -1;
+            RatioArgmax::scan(g, d.data(), st.n * st.n, range, SCOUT_K, st.idx(pos), best_ratio, at);
+            if (at >= 0)
+                best = Coord(at / st.n, at % st.n);
             if (best_ratio >= PATROL_MIN_RATIO && !(best == pos))
                 st.next_step[r.id] = st.first_step(st.par[r.id], pos, best);
         }
     }
-
-
+    st.prof.lap(TickProfile::PATROL);
 }
 
-bool Scheduler::on_task_reached(const set<Coord> &observed_coords,
-                                const set<Coord> &updated_coords,
-                                const vector<vector<vector<int>>> &known_cost_map,
-                                const vector<vector<OBJECT>> &known_object_map,
-                                const vector<shared_ptr<TASK>> &active_tasks,
-                                const vector<shared_ptr<ROBOT>> &robots,
-                                const ROBOT &robot,
-                                const TASK &task)
+bool Scheduler::State::reach_task(const vector<shared_ptr<ROBOT>> &robots, const ROBOT &robot, const TASK &task)
 {
-    State &st = *s_;
+    State &st = *this;
     if (robot.type == ROBOT::TYPE::DRONE)
         return false; // a drone can never finish a task and would burn out
     if (task.is_done())
@@ -1517,15 +2480,9 @@ bool Scheduler::on_task_reached(const set<Coord> &observed_coords,
     return true;
 }
 
-ROBOT::ACTION Scheduler::idle_action(const set<Coord> &observed_coords,
-                                     const set<Coord> &updated_coords,
-                                     const vector<vector<vector<int>>> &known_cost_map,
-                                     const vector<vector<OBJECT>> &known_object_map,
-                                     const vector<shared_ptr<TASK>> &active_tasks,
-                                     const vector<shared_ptr<ROBOT>> &robots,
-                                     const ROBOT &robot)
+ROBOT::ACTION Scheduler::State::step_action(const GRID_VIEW<OBJECT> &known_object_map, const ROBOT &robot) const
 {
-    State &st = *s_;
+    const State &st = *this;
     if (robot.id >= static_cast<int>(st.next_step.size()))
         return ROBOT::ACTION::HOLD;
     Coord cur = robot.get_coord();
@@ -1545,3 +2502,68 @@ ROBOT::ACTION Scheduler::idle_action(const set<Coord> &observed_coords,
         return ROBOT::ACTION::LEFT;
     return ROBOT::ACTION::RIGHT;
 }
+
+bool Scheduler::on_task_reached(const CELL_BITMAP &observed_coords,
+                                const CELL_BITMAP &updated_coords,
+                                const GRID_VIEW<int> &known_cost_map,
+                                const GRID_VIEW<OBJECT> &known_object_map,
+                                const vector<shared_ptr<TASK>> &active_tasks,
+                                const vector<shared_ptr<ROBOT>> &robots,
+                                const ROBOT &robot,
+                                const TASK &task)
+{
+    return s_->reach_task(robots, robot, task);
+}
+
+ROBOT::ACTION Scheduler::idle_action(const CELL_BITMAP &observed_coords,
+                                     const CELL_BITMAP &updated_coords,
+                                     const GRID_VIEW<int> &known_cost_map,
+                                     const GRID_VIEW<OBJECT> &known_object_map,
+                                     const vector<shared_ptr<TASK>> &active_tasks,
+                                     const vector<shared_ptr<ROBOT>> &robots,
+                                     const ROBOT &robot)
+{
+    return s_->step_action(known_object_map, robot);
+}
+
+vector<Scheduler::Decision> Scheduler::decide_all(const TickView &view)
+{
+    State &st = *s_;
+    vector<Decision> out;
+    // Known task cells -> the task there.  A task a robot earlier in this
+    // batch starts on is taken, exactly as if it had already started.
+    vector<int> &at = st.task_at_cell;
+    if (static_cast<int>(at.size()) != st.n * st.n)
+        at.assign(st.n * st.n, -1);
+    for (size_t i = 0; i < view.active_tasks.size(); ++i)
+        at[st.idx(view.active_tasks[i]->coord)] = static_cast<int>(i);
+    for (size_t i = 0; i < view.robots.size(); ++i)
+    {
+        const ROBOT &robot = *view.robots[i];
+        if (robot.get_status() != ROBOT::STATUS::IDLE)
+            continue;
+        Decision d;
+        d.robot = robot.id;
+        d.work = false;
+        d.task = -1;
+        d.action = ROBOT::ACTION::HOLD;
+        Coord c = robot.get_coord();
+        if (bool(view.known_object_map[c.x][c.y] & OBJECT::TASK) && at[st.idx(c)] >= 0)
+        {
+            int &slot = at[st.idx(c)];
+            const TASK &task = *view.active_tasks[slot];
+            if (st.reach_task(view.robots, robot, task))
+            {
+                d.work = true;
+                d.task = task.id;
+                slot = -1;
+            }
+        }
+        if (!d.work)
+            d.action = st.step_action(view.known_object_map, robot);
+        out.push_back(d);
+    }
+    for (size_t i = 0; i < view.active_tasks.size(); ++i)
+        at[st.idx(view.active_tasks[i]->coord)] = -1;
+    return out;
+}
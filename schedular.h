@@ -2,38 +2,89 @@
 #define SCHEDULER_H_
 
 #include "simulator.h"
+#include "tick_profile.h"
 #include <memory>
 
 class Scheduler
 {
 public:
     Scheduler();
+    // A copy plans exactly as the original would from the same tick on: all
+    // of the planning state is copied, only solver scratch is started anew.
+    // That includes every robot's distance fields, O(robots * n^2) in all.
+    Scheduler(const Scheduler &other);
+    Scheduler &operator=(const Scheduler &other);
     ~Scheduler();
 
-    void on_info_updated(const set<Coord> &observed_coords,
-                         const set<Coord> &updated_coords,
-                         const vector<vector<vector<int>>> &known_cost_map,
-                         const vector<vector<OBJECT>> &known_object_map,
+    // Wall-clock budget for the planning in each on_info_updated call, in
+    // microseconds.  The fleet plan is then improved until the budget runs
+    // out and picked up again next tick; 0 turns the deadline off, and a
+    // negative value (the default) defers to SCHED_T_DEADLINE.  Only the
+    // fleet plan is bounded: distance fields, serve_dist and the drone and
+    // patrol scans run in full, so this is a planning budget, not a bound on
+    // the tick's latency.
+    void set_tick_budget(long long microseconds);
+
+    // Phase times and work counters of the last on_info_updated call.
+    const TickProfile &profile() const;
+
+    // Optional: everything that changed in the map since the previous
+    // on_info_updated, pushed just before the next one (and cleared by the
+    // caller after).  A scheduler fed deltas keeps its task snapshot and robot
+    // tables from the events rather than rescanning the lists, and probes only
+    // the revealed cells rather than the known map.
+    void on_delta(const MAP_DELTA &delta);
+
+    void on_info_updated(const CELL_BITMAP &observed_coords,
+                         const CELL_BITMAP &updated_coords,
+                         const GRID_VIEW<int> &known_cost_map,
+                         const GRID_VIEW<OBJECT> &known_object_map,
                          const vector<shared_ptr<TASK>> &active_tasks,
                          const vector<shared_ptr<ROBOT>> &robots);
 
-    bool on_task_reached(const set<Coord> &observed_coords,
-                         const set<Coord> &updated_coords,
-                         const vector<vector<vector<int>>> &known_cost_map,
-                         const vector<vector<OBJECT>> &known_object_map,
+    bool on_task_reached(const CELL_BITMAP &observed_coords,
+                         const CELL_BITMAP &updated_coords,
+                         const GRID_VIEW<int> &known_cost_map,
+                         const GRID_VIEW<OBJECT> &known_object_map,
                          const vector<shared_ptr<TASK>> &active_tasks,
                          const vector<shared_ptr<ROBOT>> &robots,
                          const ROBOT &robot,
                          const TASK &task);
 
-    ROBOT::ACTION idle_action(const set<Coord> &observed_coords,
-                              const set<Coord> &updated_coords,
-                              const vector<vector<vector<int>>> &known_cost_map,
-                              const vector<vector<OBJECT>> &known_object_map,
+    ROBOT::ACTION idle_action(const CELL_BITMAP &observed_coords,
+                              const CELL_BITMAP &updated_coords,
+                              const GRID_VIEW<int> &known_cost_map,
+                              const GRID_VIEW<OBJECT> &known_object_map,
                               const vector<shared_ptr<TASK>> &active_tasks,
                               const vector<shared_ptr<ROBOT>> &robots,
                               const ROBOT &robot);
 
+    // Everything on_task_reached / idle_action are handed, gathered once.
+    struct TickView
+    {
+        const CELL_BITMAP &observed_coords;
+        const CELL_BITMAP &updated_coords;
+        GRID_VIEW<int> known_cost_map;
+        GRID_VIEW<OBJECT> known_object_map;
+        const vector<shared_ptr<TASK>> &active_tasks;
+        const vector<shared_ptr<ROBOT>> &robots;
+    };
+    struct Decision
+    {
+        int robot;            // robot id
+        bool work;            // start working the task on its cell
+        int task;             // that task's id, when work
+        ROBOT::ACTION action; // otherwise: the move to start (HOLD included)
+    };
+    // One decision per IDLE robot, in robots order: the same answers
+    // on_task_reached and idle_action would give robot by robot, with a task
+    // started by an earlier robot counted as taken for the later ones.  All
+    // are made before any robot acts, so they cannot see a task that a robot
+    // earlier in the same tick completes or drops (by running out of energy
+    // while working it); a caller applying them in order asks a robot on such
+    // a cell again through on_task_reached / idle_action, as SIMULATION does.
+    vector<Decision> decide_all(const TickView &view);
+
 private:
     // All planning state and helpers live in schedular.cpp (see Scheduler::State).
     struct State;
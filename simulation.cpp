@@ -0,0 +1,207 @@
+#include "simulation.h"
+#include <cassert>
+
+SIMULATION::CONFIG SIMULATION::resolve(CONFIG config)
+{
+    if (config.num_initial_tasks < 0)
+        config.num_initial_tasks = config.num_max_tasks / 2;
+    if (config.time_max < 0)
+        config.time_max = config.map_size * 100;
+    if (config.robot_energy < 0)
+        config.robot_energy = config.time_max * 6;
+    return config;
+}
+
+SIMULATION::SIMULATION(const CONFIG &config)
+    : cfg(resolve(config)),
+      sim_map(cfg.map_size, cfg.num_robot, cfg.num_initial_tasks, cfg.num_max_tasks, cfg.wall_density,
+              cfg.robot_energy, cfg.rng),
+      dispatcher(sim_map, cfg.time_max),
+      empty_coords(cfg.map_size)
+{
+    observed_coords = &empty_coords;
+    updated_coords = &empty_coords;
+    sim_map.record_delta(true);
+}
+
+SIMULATION::SIMULATION(const CONFIG &config, const SNAPSHOT &snapshot)
+    : cfg(resolve(config)),
+      sim_map(snapshot.world),
+      dispatcher(sim_map, cfg.time_max),
+      sched(*snapshot.scheduler),
+      empty_coords(cfg.map_size)
+{
+    restore_clock(snapshot);
+    if (!sim_map.is_recording_delta()) // keep the changes the scheduler has not seen yet
+        sim_map.record_delta(true);
+}
+
+SIMULATION::SNAPSHOT SIMULATION::snapshot() const
+{
+    SNAPSHOT s;
+    s.world = sim_map.snapshot();
+    s.scheduler = make_shared<Scheduler>(sched);
+    s.next_task_arrival_time = dispatcher.get_next_task_arrival_time();
+    s.tick = tick;
+    s.over = over;
+    return s;
+}
+
+void SIMULATION::restore(const SNAPSHOT &snapshot)
+{
+    sim_map.restore(snapshot.world);
+    sched = *snapshot.scheduler;
+    restore_clock(snapshot);
+}
+
+unique_ptr<SIMULATION> SIMULATION::fork() const
+{
+    return unique_ptr<SIMULATION>(new SIMULATION(cfg, snapshot()));
+}
+
+void SIMULATION::restore_clock(const SNAPSHOT &snapshot)
+{
+    dispatcher.set_next_task_arrival_time(snapshot.next_task_arrival_time);
+    tick = snapshot.tick;
+    over = snapshot.over;
+    // Before the first tick nothing has been observed yet.
+    observed_coords = tick < 0 ? &empty_coords : &sim_map.last_observed();
+    updated_coords = tick < 0 ? &empty_coords : &sim_map.last_updated();
+}
+
+bool SIMULATION::step()
+{
+    if (over)
+        return false;
+    auto &robots = sim_map.get_robots();
+    if (!(++tick < cfg.time_max &&
+          robots.size() != sim_map.get_exhausted_robot_num() &&
+          sim_map.num_total_task != sim_map.get_completed_task_num()))
+    {
+        over = true;
+        return false;
+    }
+    auto &known_cost_map = sim_map.get_known_cost_map();
+    auto &known_object_map = sim_map.get_known_object_map();
+    auto &active_tasks = sim_map.get_active_tasks();
+
+    dispatcher.try_dispatch(tick);
+    if (hooks.after_dispatch)
+        hooks.after_dispatch(*this);
+    observed_coords = &sim_map.observed_coord_by_robot();
+    if (hooks.after_observe)
+        hooks.after_observe(*this);
+    updated_coords = &sim_map.update_coords(*observed_coords);
+#ifdef VERBOSE
+    cout << "Time : " << tick << endl;
+    sim_map.print_object_map();
+    sim_map.print_robot_summary();
+    sim_map.print_task_summary();
+#endif // VERBOSE
+
+    const CELL_BITMAP &observed = *observed_coords;
+    const CELL_BITMAP &updated = *updated_coords;
+    const chrono::nanoseconds before = timer.time_elapsed;
+    timer.start();
+    sched.on_delta(sim_map.get_delta());
+    timer.stop();
+    const chrono::nanoseconds delta_done = timer.time_elapsed;
+    sim_map.clear_delta();
+    timer.start();
+    sched.on_info_updated(observed, updated, known_cost_map, known_object_map, active_tasks, robots);
+    timer.stop();
+    const chrono::nanoseconds info_done = timer.time_elapsed;
+    const Scheduler::TickView view = {observed, updated, known_cost_map, known_object_map, active_tasks, robots};
+    timer.start();
+    decisions = sched.decide_all(view);
+    timer.stop();
+    released.clear();
+    size_t next = 0;
+    for (auto &robot : robots)
+    {
+        auto &status = robot->get_status();
+        if (status == ROBOT::STATUS::IDLE)
+        {
+            // decisions follow robots order; nothing before a robot's turn
+            // changes whether it is idle (the task on its cell can change:
+            // see released)
+            assert(next < decisions.size() && decisions[next].robot == robot->id);
+            const Scheduler::Decision &d = decisions[next++];
+            const Coord coord = robot->get_coord();
+            if (find(released.begin(), released.end(), coord) != released.end())
+            {
+                // A robot earlier in this loop finished or gave up the task on
+                // this cell after decide_all ran: ask again, as a robot-by-robot
+                // loop would have at this point.
+                timer.start();
+                bool do_task = false;
+                if (bool(known_object_map[coord.x][coord.y] & OBJECT::TASK))
+                    do_task = sched.on_task_reached(observed, updated, known_cost_map, known_object_map, active_tasks,
+                                                    robots, *robot, sim_map.get_task(sim_map.get_task_id_at(coord)));
+                ROBOT::ACTION action = ROBOT::ACTION::HOLD;
+                if (!do_task)
+                    action = sched.idle_action(observed, updated, known_cost_map, known_object_map, active_tasks,
+                                               robots, *robot);
+                timer.stop();
+                if (do_task)
+                    robot->start_working(sim_map.get_task_id_at(coord));
+                else
+                    robot->start_moving(action);
+            }
+            else if (d.work)
+                robot->start_working(d.task);
+            else
+                robot->start_moving(d.action);
+        }
+
+        if (status == ROBOT::STATUS::MOVING)
+        {
+            robot->move();
+        }
+        else if (status == ROBOT::STATUS::WORKING)
+        {
+            robot->work();
+            if (status != ROBOT::STATUS::WORKING) // finished, or dropped it exhausted
+                released.push_back(robot->get_coord());
+        }
+    }
+    tick_time = timer.time_elapsed - before;
+    latency.record(tick_time.count());
+    delta_latency.record((delta_done - before).count());
+    info_latency.record((info_done - delta_done).count());
+    decide_latency.record((timer.time_elapsed - info_done).count());
+    if (hooks.after_tick)
+        hooks.after_tick(*this);
+    return true;
+}
+
+SIMULATION::RESULT SIMULATION::run()
+{
+    while (step())
+        ;
+    return result();
+}
+
+SIMULATION::RESULT SIMULATION::result() const
+{
+    const MAP &m = sim_map;
+    RESULT r;
+    r.completed = m.get_completed_task_num();
+    r.discovered = r.completed + static_cast<int>(m.get_active_tasks().size());
+    r.created = static_cast<int>(m.get_tasks().size());
+    r.exhausted = m.get_exhausted_robot_num();
+    r.end_time = tick;
+    for (auto &robot : m.get_robots())
+    {
+        if (robot->type == ROBOT::TYPE::DRONE)
+            r.drone_energy += robot->get_energy();
+        else
+            r.worker_energy += robot->get_energy();
+    }
+    r.scheduler_time = timer.time_elapsed;
+    r.tick_latency = latency;
+    r.delta_latency = delta_latency;
+    r.info_latency = info_latency;
+    r.decide_latency = decide_latency;
+    return r;
+}
@@ -0,0 +1,129 @@
+#ifndef SIMULATION_H_
+#define SIMULATION_H_
+
+#include "simulator.h"
+#include "schedular.h"
+#include "latency_histogram.h"
+
+// The simulation loop of main.cpp as a reusable engine: one MAP, its task
+// dispatcher and one Scheduler, advanced a tick at a time.  A tick is exactly
+// what main.cpp has always done -- dispatch, observe, update the known map,
+// on_info_updated (preceded by on_delta with the map's changes since the last
+// tick), then a decision for every idle robot -- asked for all at once with
+// decide_all -- and move / work -- and the run ends on the same three
+// conditions (time up, every robot exhausted, every task completed).
+//
+// Tools that need to look at or tamper with a run do it through HOOKS rather
+// than a copy of the loop.  Nothing is printed unless VERBOSE is defined.
+//
+// The run -- map, robots, tasks, dispatcher clock, RNG, tick, and a copy of
+// the Scheduler with everything it carries between ticks -- can be saved with
+// snapshot() and put back with restore(), or copied into an independent run
+// with fork(), for rollouts and what-if evaluation.  Either way the run goes
+// on exactly as the original did from that tick.
+class SIMULATION
+{
+public:
+    struct CONFIG
+    {
+        int map_size = 20;
+        int num_robot = 6;
+        int num_max_tasks = 16;
+        int num_initial_tasks = -1; // -1: num_max_tasks / 2
+        int wall_density = 20;
+        int time_max = -1;          // -1: map_size * 100
+        int robot_energy = -1;      // -1: time_max * 6
+        RNG rng;
+    };
+    struct RESULT
+    {
+        int created = 0;
+        int discovered = 0; // completed + still active
+        int completed = 0;
+        int exhausted = 0;
+        int end_time = 0;      // the tick the loop stopped at
+        int worker_energy = 0; // energy left, caterpillars and wheels
+        int drone_energy = 0;  // energy left, drones
+        chrono::nanoseconds scheduler_time = chrono::nanoseconds::zero(); // inside Scheduler callbacks
+        LatencyHistogram tick_latency;   // scheduler_time, tick by tick
+        // The same split by callback: on_delta, on_info_updated, and the
+        // decisions (decide_all plus any robot asked again in the robot loop).
+        LatencyHistogram delta_latency;
+        LatencyHistogram info_latency;
+        LatencyHistogram decide_latency;
+    };
+    // Called once per tick with the tick already advanced; any may be empty.
+    struct HOOKS
+    {
+        function<void(SIMULATION &)> after_dispatch; // new tasks placed, nothing observed yet
+        function<void(SIMULATION &)> after_observe;  // observed() set, known map not yet updated
+        function<void(SIMULATION &)> after_tick;     // every robot has moved or worked
+    };
+    struct SNAPSHOT
+    {
+        MAP::SNAPSHOT world;
+        shared_ptr<const Scheduler> scheduler; // its state at that tick
+        int next_task_arrival_time = 0;
+        int tick = -1;
+        bool over = false;
+    };
+
+    explicit SIMULATION(const CONFIG &config);
+    // A run that continues from `snapshot`, taken from a run with this config.
+    SIMULATION(const CONFIG &config, const SNAPSHOT &snapshot);
+    SIMULATION(const SIMULATION &) = delete;
+    SIMULATION &operator=(const SIMULATION &) = delete;
+
+    // Runs one tick; false (and nothing done) once the run is over.
+    bool step();
+    // Steps until the run is over.
+    RESULT run();
+    RESULT result() const;
+
+    // A full copy of the run.  Most of it is the Scheduler's: a few n*n
+    // distance fields per robot (routed and clean distances, parents, the
+    // repair state behind them) and the per-task field arena, so a snapshot
+    // costs O(robots * n^2) time and memory over the map's own grids.  That
+    // is small on the bench maps but adds up when snapshotting every tick of
+    // a large one.  fork() pays the same.
+    SNAPSHOT snapshot() const;
+    // Rewinds (or fast-forwards) the run to `snapshot`, scheduler included;
+    // hooks and the timings are left alone.
+    void restore(const SNAPSHOT &snapshot);
+    // An independent copy of this run at its current tick, with no hooks.
+    unique_ptr<SIMULATION> fork() const;
+
+    bool finished() const { return over; }
+    // Time spent in Scheduler callbacks during the last tick.
+    chrono::nanoseconds tick_scheduler_time() const { return tick_time; }
+    int time() const { return tick; }
+    const CONFIG &config() const { return cfg; }
+    MAP &map() { return sim_map; }
+    Scheduler &scheduler() { return sched; }
+    // This tick's observation and known-map change, as the scheduler sees them.
+    const CELL_BITMAP &observed() const { return *observed_coords; }
+    const CELL_BITMAP &updated() const { return *updated_coords; }
+
+    HOOKS hooks;
+
+private:
+    static CONFIG resolve(CONFIG config);
+    void restore_clock(const SNAPSHOT &snapshot);
+
+    const CONFIG cfg;
+    MAP sim_map;
+    TASKDISPATCHER dispatcher;
+    Scheduler sched;
+    TIMER timer;
+    chrono::nanoseconds tick_time = chrono::nanoseconds::zero();
+    LatencyHistogram latency, delta_latency, info_latency, decide_latency;
+    int tick = -1;
+    bool over = false;
+    const CELL_BITMAP *observed_coords;
+    const CELL_BITMAP *updated_coords;
+    CELL_BITMAP empty_coords;
+    vector<Scheduler::Decision> decisions;
+    vector<Coord> released; // cells whose task a robot let go of this tick
+};
+
+#endif // SIMULATION_H_
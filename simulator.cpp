@@ -46,29 +46,38 @@ OBJECT operator~(OBJECT obj) { return OBJECT(~static_cast<int>(obj)); }
 // OBJECT type end
 
 // ROBOT
-bool ROBOT::start_moving(ACTION action) { return this->map.start_robot_moving(*this, action); };
-bool ROBOT::start_working(weak_ptr<TASK> task)
+bool ROBOT::start_moving(ACTION action)
 {
-    if (coord != task.lock()->coord)
+    const STATUS from = status;
+    bool moving = this->map.start_robot_moving(*this, action);
+    map.note_robot(*this, from, coord, -1);
+    return moving;
+}
+bool ROBOT::start_working(int task_id)
+{
+    TASK &task = map.get_task(task_id);
+    if (coord != task.coord)
     {
-        cout << "Robot " << id << coord << " is not at task " << task.lock()->id << task.lock()->coord << endl;
+        cout << "Robot " << id << coord << " is not at task " << task.id << task.coord << endl;
         return false;
     }
-    if (!task.lock()->assigned_robot.expired())
+    if (task.assigned_robot >= 0)
     {
-        cout << "Task " << task.lock()->id << " is already assigned to Robot " << task.lock()->assigned_robot.lock()->id << endl;
+        cout << "Task " << task.id << " is already assigned to Robot " << task.assigned_robot << endl;
     }
-    assigned_task = task;
-    auto r = shared_from_this();
-    task.lock()->assigned_robot = r;
-    remain_progress = task.lock()->task_cost[static_cast<size_t>(type)];
+    assigned_task = task_id;
+    task.assigned_robot = id;
+    remain_progress = task.task_cost[static_cast<size_t>(type)];
+    const STATUS from = status;
     status = ROBOT::STATUS::WORKING;
+    map.note_robot(*this, from, coord, task_id);
 #ifdef VERBOSE
-    cout << "Task " << task.lock()->id << " at " << task.lock()->coord << " is assigned to Robot " << id << endl;
+    cout << "Task " << task.id << " at " << task.coord << " is assigned to Robot " << id << endl;
 #endif // VERBOSE
 
     return true;
 }
+bool ROBOT::start_working(weak_ptr<TASK> task) { return start_working(task.lock()->id); }
 int ROBOT::move()
 {
     if (status != ROBOT::STATUS::MOVING)
@@ -76,6 +85,8 @@ int ROBOT::move()
         cout << "Robot " << id << " is not in moving." << endl;
         return -1;
     }
+    const STATUS from = status;
+    const Coord from_coord = coord;
     remain_progress -= energy_per_tick_list[static_cast<size_t>(type)];
     if (coord != target_coord && remain_progress <= 0)
     {
@@ -94,6 +105,7 @@ int ROBOT::move()
         remain_progress = 0;
     }
     consume_energy();
+    map.note_robot(*this, from, from_coord, -1);
     return remain_progress;
 }
 int ROBOT::work()
@@ -103,6 +115,8 @@ int ROBOT::work()
         cout << "Robot " << id << " is not in working." << endl;
         return -1;
     }
+    const STATUS from = status;
+    const int task = assigned_task;
     remain_progress -= energy_per_tick_list[static_cast<size_t>(type)];
     consume_energy();
     if (remain_progress <= 0)
@@ -110,12 +124,13 @@ int ROBOT::work()
         remain_progress = 0;
         map.complete_task(assigned_task);
         status = STATUS::IDLE;
-        assigned_task.reset();
+        assigned_task = -1;
     }
     else if (status == ROBOT::STATUS::EXHAUSTED)
     {
-        assigned_task.lock()->assigned_robot.reset();
+        map.get_task(assigned_task).assigned_robot = -1;
     }
+    map.note_robot(*this, from, coord, task);
     return remain_progress;
 }
 int ROBOT::consume_energy()
@@ -131,6 +146,11 @@ int ROBOT::consume_energy()
 }
 // ROBOT end
 
+// TASK
+TASK::TASK(Coord coord, int id, MAP &map)
+    : TASK(coord, id, {DRONE_DEFAULT_COST, map.get_rng()() % CATERPILLAR_COST_EXCLUSIVE_UPPER_BOUND + CATERPILLAR_COST_MIN, map.get_rng()() % WHEEL_COST_EXCLUSIVE_UPPER_BOUND + WHEEL_COST_MIN}, map) {}
+// TASK end
+
 // TASKDISPATCHER
 bool TASKDISPATCHER::try_dispatch(int current_time)
 {
@@ -361,7 +381,7 @@ void MAP::print_robot_summary() const
              << right << setw(6) << robot->energy << "  "
              << left << setw(9) << robot->status << "  "
              << left << setw(11) << robot->target_coord << "  "
-             << right << setw(4) << ((robot->assigned_task.expired()) ? "No" : to_string(robot->assigned_task.lock()->id)) << "  "
+             << right << setw(4) << ((robot->assigned_task < 0) ? "No" : to_string(robot->assigned_task)) << "  "
              << endl;
     }
     cout << endl;
@@ -383,7 +403,7 @@ void MAP::print_task_summary() const
              << setw(10) << task->coord
              << setw(7) << bool_str(task->done || bool(known_object_at(task->coord) & OBJECT::TASK))
              << setw(7) << bool_str(task->done) << "  "
-             << right << setw(8) << ((task->assigned_robot.expired()) ? "No" : to_string(task->assigned_robot.lock()->id));
+             << right << setw(8) << ((task->assigned_robot < 0) ? "No" : to_string(task->assigned_robot));
         for (int i = 1; i < ROBOT::NUM_ROBOT_TYPE; ++i)
         {
             cout << setw(to_string(ROBOT::TYPE(i)).size() + 2) << task->task_cost[i];
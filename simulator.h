@@ -14,6 +14,12 @@
 #include <conio.h>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 // #define VERBOSE
 
@@ -68,6 +74,194 @@ public:
     bool operator<(const Coord &rhs) const { return (this->x == rhs.x) ? this->y < rhs.y : this->x < rhs.x; }
 };
 
+// Dense grid storage.  Every layer is one contiguous row-major plane and the
+// planes are stacked type-major, so cell (x, y) of layer l lives at
+// (l * size + x) * size + y -- one allocation per grid instead of one per row
+// and one per cell.  grid[x][y] reads layer 0, like the nested vectors it replaces.
+template <typename T>
+class GRID
+{
+public:
+    GRID() {}
+    GRID(int size, int layers, const T &value) : n(size), num_layers(layers), cells(static_cast<size_t>(layers) * size * size, value) {}
+
+    int size() const noexcept { return n; }
+    int layers() const noexcept { return num_layers; }
+    T &at(int x, int y, int layer = 0) { return cells[(static_cast<size_t>(layer) * n + x) * n + y]; }
+    const T &at(int x, int y, int layer = 0) const { return cells[(static_cast<size_t>(layer) * n + x) * n + y]; }
+    T &at(const Coord &coord, int layer = 0) { return at(coord.x, coord.y, layer); }
+    const T &at(const Coord &coord, int layer = 0) const { return at(coord.x, coord.y, layer); }
+    T *operator[](int x) { return cells.data() + static_cast<size_t>(x) * n; }
+    const T *operator[](int x) const { return cells.data() + static_cast<size_t>(x) * n; }
+    T *plane(int layer) { return cells.data() + static_cast<size_t>(layer) * n * n; }
+    const T *plane(int layer) const { return cells.data() + static_cast<size_t>(layer) * n * n; }
+    void fill(const T &value) { std::fill(cells.begin(), cells.end(), value); }
+
+private:
+    int n = 0;
+    int num_layers = 0;
+    vector<T> cells;
+};
+
+// Read-only, non-owning view of a GRID, handed to the scheduler.  It stays
+// valid as long as the grid is not resized, which MAP never does after
+// generate_map.
+template <typename T>
+class GRID_VIEW
+{
+public:
+    GRID_VIEW() {}
+    GRID_VIEW(const GRID<T> &grid) : cells(grid.plane(0)), n(grid.size()), num_layers(grid.layers()) {}
+
+    int size() const noexcept { return n; }
+    int layers() const noexcept { return num_layers; }
+    const T &at(int x, int y, int layer = 0) const { return cells[(static_cast<size_t>(layer) * n + x) * n + y]; }
+    const T &at(const Coord &coord, int layer = 0) const { return at(coord.x, coord.y, layer); }
+    const T *operator[](int x) const { return cells + static_cast<size_t>(x) * n; }
+    const T *plane(int layer) const { return cells + static_cast<size_t>(layer) * n * n; }
+
+private:
+    const T *cells = nullptr;
+    int n = 0;
+    int num_layers = 0;
+};
+
+// Set of cells stored as one bit per cell, bit x * size + y.  Iteration
+// visits cells in the same (x, y) order as set<Coord>, and a robot's view
+// window is a handful of contiguous bit runs, so building the per-tick
+// observation set costs O(cells / 64) word operations and no allocation once
+// the bitmap exists.
+class CELL_BITMAP
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator(const CELL_BITMAP *bitmap, size_t word) : bitmap(bitmap), word(word), bits(0)
+        {
+            if (word < bitmap->words.size())
+                bits = bitmap->words[word];
+            skip_empty();
+        }
+        Coord operator*() const
+        {
+            int i = static_cast<int>(word * 64 + lowest_bit(bits));
+            return {i / bitmap->n, i % bitmap->n};
+        }
+        const_iterator &operator++()
+        {
+            bits &= bits - 1;
+            skip_empty();
+            return *this;
+        }
+        bool operator==(const const_iterator &rhs) const { return word == rhs.word && bits == rhs.bits; }
+        bool operator!=(const const_iterator &rhs) const { return !((*this) == rhs); }
+
+    private:
+        const CELL_BITMAP *bitmap;
+        size_t word;
+        uint64_t bits;
+        void skip_empty()
+        {
+            while (bits == 0 && ++word < bitmap->words.size())
+                bits = bitmap->words[word];
+            if (bits == 0)
+                word = bitmap->words.size();
+        }
+    };
+
+    CELL_BITMAP() {}
+    explicit CELL_BITMAP(int size) : n(size), words((static_cast<size_t>(size) * size + 63) / 64, 0) {}
+
+    int map_size() const noexcept { return n; }
+    bool contains(const Coord &coord) const { return contains_index(coord.x * n + coord.y); }
+    size_t count(const Coord &coord) const { return contains(coord) ? 1 : 0; }
+    void insert(const Coord &coord) { insert_index(coord.x * n + coord.y); }
+    void emplace(int x, int y) { insert_index(x * n + y); }
+    // Insert cells (x, y0) .. (x, y1), clipped to the map.
+    void insert_column(int x, int y0, int y1)
+    {
+        if (x < 0 || x >= n)
+            return;
+        y0 = max(y0, 0);
+        y1 = min(y1, n - 1);
+        if (y0 <= y1)
+            set_bits(static_cast<size_t>(x) * n + y0, static_cast<size_t>(x) * n + y1 + 1);
+    }
+    // Insert every cell (x0 .. x1, y0 .. y1), clipped to the map.
+    void insert_window(int x0, int x1, int y0, int y1)
+    {
+        for (int x = max(x0, 0); x <= min(x1, n - 1); ++x)
+            insert_column(x, y0, y1);
+    }
+    void fill()
+    {
+        set_bits(0, static_cast<size_t>(n) * n);
+    }
+    void clear() { std::fill(words.begin(), words.end(), 0); }
+    bool empty() const
+    {
+        for (uint64_t w : words)
+            if (w)
+                return false;
+        return true;
+    }
+    size_t size() const
+    {
+        size_t total = 0;
+        for (uint64_t w : words)
+            total += bit_count(w);
+        return total;
+    }
+    CELL_BITMAP &operator|=(const CELL_BITMAP &rhs)
+    {
+        for (size_t i = 0; i < words.size(); ++i)
+            words[i] |= rhs.words[i];
+        return *this;
+    }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, words.size()); }
+    const vector<uint64_t> &data() const noexcept { return words; }
+
+private:
+    int n = 0;
+    vector<uint64_t> words;
+
+    bool contains_index(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void insert_index(int i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    // Set bits [from, to) a word at a time.
+    void set_bits(size_t from, size_t to)
+    {
+        while (from < to)
+        {
+            size_t w = from >> 6;
+            size_t lo = from & 63;
+            size_t hi = min<size_t>(64, lo + (to - from));
+            uint64_t mask = (hi == 64) ? ~uint64_t(0) << lo : ((uint64_t(1) << hi) - 1) & (~uint64_t(0) << lo);
+            words[w] |= mask;
+            from += hi - lo;
+        }
+    }
+    static int lowest_bit(uint64_t w)
+    {
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward64(&i, w);
+        return static_cast<int>(i);
+#else
+        return __builtin_ctzll(w);
+#endif
+    }
+    static int bit_count(uint64_t w)
+    {
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt64(w));
+#else
+        return __builtin_popcountll(w);
+#endif
+    }
+};
+
 class TIMER
 {
 public:
@@ -78,7 +272,103 @@ public:
     chrono::high_resolution_clock::time_point start_time;
 };
 
-class ROBOT : public enable_shared_from_this<ROBOT>
+// glibc's rand(), bit for bit: the additive feedback generator behind
+// random(), seeded the way srand() seeds it.
+class GLIBC_RAND
+{
+public:
+    GLIBC_RAND() { seed(1); } // rand() before any srand() behaves as srand(1)
+    void seed(unsigned int s)
+    {
+        int32_t word = static_cast<int32_t>(s == 0 ? 1 : s);
+        state[0] = word;
+        for (int i = 1; i < DEG; ++i)
+        {
+            // state[i] = 16807 * state[i - 1] % 2147483647 without overflow
+            long hi = word / 127773, lo = word % 127773;
+            word = static_cast<int32_t>(16807 * lo - 2836 * hi);
+            if (word < 0)
+                word += 2147483647;
+            state[i] = word;
+        }
+        f = SEP;
+        r = 0;
+        for (int i = 0; i < DEG * 10; ++i)
+            next();
+    }
+    int next()
+    {
+        uint32_t v = static_cast<uint32_t>(state[f]) + static_cast<uint32_t>(state[r]);
+        state[f] = static_cast<int32_t>(v);
+        f = (f + 1) % DEG;
+        r = (r + 1) % DEG;
+        return static_cast<int>(v >> 1);
+    }
+
+private:
+    static constexpr int DEG = 31, SEP = 3;
+    int32_t state[DEG];
+    int f = SEP, r = 0;
+};
+
+// Random source of one simulation.  Every MAP owns one -- map generation, task
+// costs and dispatch all draw from it -- so simulations never share a stream
+// and can run side by side on different threads.  Draws are uniform on
+// [0, 2^31), like rand() on glibc.
+//   GLIBC   reproduces srand(seed)/rand() exactly, on any platform, so seeds
+//           keep the maps they have always had (the default).
+//   XOSHIRO xoshiro256**, seeded through splitmix64: faster and statistically
+//           sounder, but a different map for the same seed.
+class RNG
+{
+public:
+    enum class KIND
+    {
+        GLIBC,
+        XOSHIRO,
+    };
+    explicit RNG(unsigned int seed = 1, KIND kind = KIND::GLIBC) : rng_kind(kind) { this->seed(seed); }
+    void seed(unsigned int s)
+    {
+        if (rng_kind == KIND::GLIBC)
+        {
+            glibc.seed(s);
+            return;
+        }
+        uint64_t z = s;
+        for (int i = 0; i < 4; ++i)
+        {
+            z += 0x9e3779b97f4a7c15ULL;
+            uint64_t v = z;
+            v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            v = (v ^ (v >> 27)) * 0x94d049bb133111ebULL;
+            x[i] = v ^ (v >> 31);
+        }
+    }
+    int operator()()
+    {
+        if (rng_kind == KIND::GLIBC)
+            return glibc.next();
+        uint64_t result = rotl(x[1] * 5, 7) * 9;
+        uint64_t t = x[1] << 17;
+        x[2] ^= x[0];
+        x[3] ^= x[1];
+        x[1] ^= x[2];
+        x[0] ^= x[3];
+        x[2] ^= t;
+        x[3] = rotl(x[3], 45);
+        return static_cast<int>(result >> 33);
+    }
+    KIND kind() const { return rng_kind; }
+
+private:
+    static uint64_t rotl(uint64_t v, int k) { return (v << k) | (v >> (64 - k)); }
+    KIND rng_kind;
+    GLIBC_RAND glibc;
+    uint64_t x[4] = {0, 0, 0, 0};
+};
+
+class ROBOT
 {
     friend class MAP;
 
@@ -212,10 +502,12 @@ public:
     const STATUS &get_status() const noexcept { return this->status; }
     const Coord &get_target_coord() const noexcept { return target_coord; }
     int get_energy() const noexcept { return energy; }
+    int get_assigned_task_id() const noexcept { return assigned_task; }
 
     // Public methods
 
     bool start_moving(ACTION action);
+    bool start_working(int task_id);
     bool start_working(weak_ptr<TASK> task);
     int move();
     int work();
@@ -229,7 +521,7 @@ private:
     Coord coord;
     STATUS status;
     int energy;
-    weak_ptr<TASK> assigned_task;
+    int assigned_task = -1; // task id, -1 if none
     Coord target_coord = {-1, -1};
     int remain_progress = 0;
 
@@ -242,7 +534,7 @@ class TASK
 {
     friend class MAP;
     friend std::ostream &operator<<(std::ostream &o, const TASK &task);
-    friend bool ROBOT::start_working(weak_ptr<TASK> task);
+    friend bool ROBOT::start_working(int task_id);
     friend int ROBOT::work();
 
 public:
@@ -254,12 +546,12 @@ public:
 
     // Public Constructor
 
-    TASK(Coord coord, int id, MAP &map) : TASK(coord, id, {DRONE_DEFAULT_COST, rand() % CATERPILLAR_COST_EXCLUSIVE_UPPER_BOUND + CATERPILLAR_COST_MIN, rand() % WHEEL_COST_EXCLUSIVE_UPPER_BOUND + WHEEL_COST_MIN}, map) {}
+    TASK(Coord coord, int id, MAP &map); // costs drawn from the map's RNG
 
     // Public methods
 
     bool is_done() const { return done; }
-    int get_assigned_robot_id() const { return (assigned_robot.expired()) ? -1 : assigned_robot.lock()->id; }
+    int get_assigned_robot_id() const { return assigned_robot; }
     /* Get task cost by type */
     int get_cost(ROBOT::TYPE type) const { return task_cost[static_cast<size_t>(type)]; }
 
@@ -270,7 +562,7 @@ private:
     // Private variables
 
     bool done = false;
-    weak_ptr<ROBOT> assigned_robot;
+    int assigned_robot = -1; // robot id, -1 if none
     MAP &map;
 
     // Private static constants
@@ -281,6 +573,44 @@ private:
     static constexpr int WHEEL_COST_MIN = 0;
 };
 
+// What changed in a MAP since its delta was last cleared, recorded as it
+// happens: cells whose known state changed in update_coords, tasks found,
+// completed or forgotten, and every robot status change or move.  A
+// scheduler can keep its own state current from this in O(changes) instead
+// of rescanning the known map, the active tasks and the robots each tick.
+// Recording is off until MAP::record_delta(true).
+struct MAP_DELTA
+{
+    struct TASK_CHANGE
+    {
+        enum KIND
+        {
+            DISCOVERED, // added to the end of the active tasks
+            COMPLETED,  // removed from them (last entry swapped into its place)
+            FORGOTTEN   // removed by clear_active_tasks, the same way
+        } kind;
+        int id;
+    };
+    struct ROBOT_CHANGE
+    {
+        int id;
+        ROBOT::STATUS from, to;
+        Coord from_coord, to_coord;
+        int task; // the task it works, or worked until this change; -1 if none
+    };
+    vector<Coord> revealed;      // known cost / object changed
+    vector<TASK_CHANGE> tasks;   // in the order they happened
+    vector<ROBOT_CHANGE> robots; // in the order they happened
+
+    bool empty() const { return revealed.empty() && tasks.empty() && robots.empty(); }
+    void clear()
+    {
+        revealed.clear();
+        tasks.clear();
+        robots.clear();
+    }
+};
+
 class TASKDISPATCHER
 {
 public:
@@ -290,6 +620,9 @@ public:
     }
 
     bool try_dispatch(int current_time);
+    // The dispatcher's only state, for snapshots.
+    int get_next_task_arrival_time() const { return next_task_arrival_time; }
+    void set_next_task_arrival_time(int t) { next_task_arrival_time = t; }
 
 private:
     MAP &map;
@@ -309,30 +642,207 @@ public:
     const int time_max;
 
     // Constructor
-    MAP(int map_size, int num_robot, int num_initial_task, int num_total_task, int wall_density, int robot_energy)
-        : map_size(map_size), time_max(map_size * 100), wall_density(wall_density), num_total_task(num_total_task)
+    MAP(int map_size, int num_robot, int num_initial_task, int num_total_task, int wall_density, int robot_energy,
+        RNG rng = RNG())
+        : map_size(map_size), time_max(map_size * 100), wall_density(wall_density), num_total_task(num_total_task),
+          rng(rng)
     {
         generate_map(num_robot, num_initial_task, robot_energy);
     }
 
+    // Snapshot
+    // A complete value copy of the world: grids, robots, tasks, discovery
+    // state, the last observation and the RNG.  Robots and tasks are stored by
+    // index, linked to each other by id as in the map, so a snapshot holds no
+    // pointers and stays valid after the map it came from is gone.
+    struct SNAPSHOT
+    {
+        struct ROBOT_STATE
+        {
+            ROBOT::TYPE type;
+            Coord coord;
+            ROBOT::STATUS status;
+            int energy;
+            int task; // id of the task being worked, -1 if none
+            Coord target_coord;
+            int remain_progress;
+        };
+        struct TASK_STATE
+        {
+            Coord coord;
+            array<int, ROBOT::NUM_ROBOT_TYPE> task_cost;
+            bool done;
+            int robot; // id of the robot working it, -1 if none
+        };
+        int map_size = 0;
+        int num_total_task = 0;
+        int wall_density = 0;
+        int current_time = 0;
+        int exhausted_robot_num = 0;
+        int completed_task_num = 0;
+        vector<ROBOT_STATE> robots;
+        vector<TASK_STATE> tasks;
+        GRID<int> cost_map;
+        GRID<OBJECT> object_map;
+        GRID<int> robot_num_map;
+        GRID<int> known_cost_map;
+        GRID<OBJECT> known_object_map;
+        GRID<int> task_id_map;
+        vector<int> active; // ids, in active_tasks order
+        CELL_BITMAP previous_update;
+        CELL_BITMAP observed;
+        CELL_BITMAP updated;
+        RNG rng;
+        bool recording = false;
+        MAP_DELTA delta; // not yet cleared: part of the state between ticks
+    };
+    // A new, independent map in the snapshot's state.
+    explicit MAP(const SNAPSHOT &snapshot)
+        : map_size(snapshot.map_size), time_max(snapshot.map_size * 100), wall_density(snapshot.wall_density),
+          num_total_task(snapshot.num_total_task)
+    {
+        restore(snapshot);
+    }
+    SNAPSHOT snapshot() const
+    {
+        SNAPSHOT s;
+        s.map_size = map_size;
+        s.num_total_task = num_total_task;
+        s.wall_density = wall_density;
+        s.current_time = current_time;
+        s.exhausted_robot_num = exhausted_robot_num;
+        s.completed_task_num = completed_task_num;
+        s.robots.reserve(robots.size());
+        for (const auto &robot : robots)
+            s.robots.push_back({robot->type, robot->coord, robot->status, robot->energy, robot->assigned_task,
+                                robot->target_coord, robot->remain_progress});
+        s.tasks.reserve(tasks.size());
+        for (const auto &task : tasks)
+            s.tasks.push_back({task->coord, task->task_cost, task->done, task->assigned_robot});
+        s.cost_map = cost_map;
+        s.object_map = object_map;
+        s.robot_num_map = robot_num_map;
+        s.known_cost_map = known_cost_map;
+        s.known_object_map = known_object_map;
+        s.task_id_map = task_id_map;
+        s.active.reserve(active_tasks.size());
+        for (const auto &task : active_tasks)
+            s.active.push_back(task->id);
+        s.previous_update = previous_update;
+        s.observed = observed_buffer;
+        s.updated = updated_buffer;
+        s.rng = rng;
+        s.recording = recording;
+        s.delta = delta;
+        return s;
+    }
+    // Puts this map back into the snapshot's state.  Robot and task objects
+    // that still match are kept, so shared_ptrs held elsewhere stay valid;
+    // tasks created after the snapshot are dropped.  The snapshot must come
+    // from a map of the same size and, unless this map is new, with the same
+    // robots.
+    void restore(const SNAPSHOT &s)
+    {
+        assert(s.map_size == map_size);
+        assert(s.cost_map.size() == map_size && s.object_map.size() == map_size &&
+               s.robot_num_map.size() == map_size && s.known_cost_map.size() == map_size &&
+               s.known_object_map.size() == map_size && s.task_id_map.size() == map_size);
+        assert(s.previous_update.map_size() == map_size && s.observed.map_size() == map_size &&
+               s.updated.map_size() == map_size);
+        assert(robots.empty() || robots.size() == s.robots.size());
+        assert(s.active.size() <= s.tasks.size());
+        current_time = s.current_time;
+        exhausted_robot_num = s.exhausted_robot_num;
+        completed_task_num = s.completed_task_num;
+        cost_map = s.cost_map;
+        object_map = s.object_map;
+        robot_num_map = s.robot_num_map;
+        known_cost_map = s.known_cost_map;
+        known_object_map = s.known_object_map;
+        task_id_map = s.task_id_map;
+        previous_update = s.previous_update;
+        observed_buffer = s.observed;
+        updated_buffer = s.updated;
+        rng = s.rng;
+        recording = s.recording;
+        delta = s.delta;
+
+        robots.resize(s.robots.size());
+        for (size_t i = 0; i < robots.size(); ++i)
+        {
+            const auto &r = s.robots[i];
+            if (!robots[i] || robots[i]->type != r.type)
+                robots[i] = make_shared<ROBOT>(r.coord, r.type, static_cast<int>(i), *this, r.energy);
+        }
+        tasks.resize(s.tasks.size());
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            const auto &t = s.tasks[i];
+            if (!tasks[i] || tasks[i]->coord != t.coord || tasks[i]->task_cost != t.task_cost)
+                tasks[i] = shared_ptr<TASK>(new TASK(t.coord, static_cast<int>(i), t.task_cost, *this));
+            tasks[i]->done = t.done;
+            tasks[i]->assigned_robot = t.robot;
+        }
+        for (size_t i = 0; i < robots.size(); ++i)
+        {
+            const auto &r = s.robots[i];
+            ROBOT &robot = *robots[i];
+            robot.coord = r.coord;
+            robot.status = r.status;
+            robot.energy = r.energy;
+            robot.assigned_task = r.task;
+            robot.target_coord = r.target_coord;
+            robot.remain_progress = r.remain_progress;
+        }
+        active_tasks.clear();
+        active_index.assign(tasks.size(), -1);
+        for (size_t i = 0; i < s.active.size(); ++i)
+        {
+            assert(s.active[i] >= 0 && static_cast<size_t>(s.active[i]) < tasks.size());
+            active_index[s.active[i]] = static_cast<int>(i);
+            active_tasks.push_back(tasks[s.active[i]]);
+        }
+    }
+
     // Get methods
     Coord get_random_empty_coord() const
     {
-        Coord coord = {rand() % map_size, rand() % map_size};
+        Coord coord = {rng() % map_size, rng() % map_size};
         while (object_at(coord) != OBJECT::EMPTY)
-            coord = {rand() % map_size, rand() % map_size};
+            coord = {rng() % map_size, rng() % map_size};
         return coord;
     };
     vector<shared_ptr<ROBOT>> &get_robots() { return robots; }
+    const vector<shared_ptr<ROBOT>> &get_robots() const { return robots; }
+    RNG &get_rng() { return rng; }
     vector<shared_ptr<TASK>> &get_tasks() { return tasks; }
-    vector<vector<vector<int>>> &get_known_cost_map() { return known_cost_map; }
-    vector<vector<OBJECT>> &get_known_object_map() { return known_object_map; }
-    vector<shared_ptr<TASK>> &get_active_tasks() { return active_tasks; }
-    int get_exhausted_robot_num() { return exhausted_robot_num; }
-    int get_completed_task_num() { return completed_task_num; }
+    const vector<shared_ptr<TASK>> &get_tasks() const { return tasks; }
+    // Robots and tasks by id; an id is the index into get_robots() / get_tasks().
+    ROBOT &get_robot(int id) { return *robots[id]; }
+    const ROBOT &get_robot(int id) const { return *robots[id]; }
+    TASK &get_task(int id) { return *tasks[id]; }
+    const TASK &get_task(int id) const { return *tasks[id]; }
+    // Id of the undone task at `coord`, -1 if none.
+    int get_task_id_at(const Coord &coord) const { return task_id_map.at(coord); }
+
+    // Change feed (see MAP_DELTA).  The simulation clears it once the
+    // scheduler has seen it.
+    void record_delta(bool on)
+    {
+        recording = on;
+        delta.clear();
+    }
+    bool is_recording_delta() const { return recording; }
+    const MAP_DELTA &get_delta() const { return delta; }
+    void clear_delta() { delta.clear(); }
+    GRID<int> &get_known_cost_map() { return known_cost_map; }
+    GRID<OBJECT> &get_known_object_map() { return known_object_map; }
+    const vector<shared_ptr<TASK>> &get_active_tasks() const { return active_tasks; }
+    int get_exhausted_robot_num() const { return exhausted_robot_num; }
+    int get_completed_task_num() const { return completed_task_num; }
     int get_cost(const Coord &coord, ROBOT::TYPE type) const { return known_cost_at(coord, type); }
-    int get_robot_num_at(int x, int y) const { return robot_num_map[x][y]; }
-    int get_robot_num_at(const Coord &coord) const { return robot_num_map[coord.x][coord.y]; }
+    int get_robot_num_at(int x, int y) const { return robot_num_map.at(x, y); }
+    int get_robot_num_at(const Coord &coord) const { return robot_num_map.at(coord); }
 
     // Public method for Robot
     weak_ptr<ROBOT> create_robot(ROBOT::TYPE type, int robot_energy)
@@ -389,6 +899,12 @@ public:
         }
     }
     friend int ROBOT::consume_energy();
+    /* Records robot's change since it was at from_coord with status from. */
+    void note_robot(const ROBOT &robot, ROBOT::STATUS from, const Coord &from_coord, int task)
+    {
+        if (recording && (robot.status != from || robot.coord != from_coord))
+            delta.robots.push_back({robot.id, from, robot.status, from_coord, robot.coord, task});
+    }
 
     // Public method for Task
     weak_ptr<TASK> create_task()
@@ -397,29 +913,41 @@ public:
         tasks.emplace_back(make_shared<TASK>(coord, static_cast<int>(tasks.size()), *this));
         auto task = tasks.back();
         object_at(coord) |= OBJECT::TASK;
+        task_id_at(coord) = task->id;
+        active_index.push_back(-1);
         return task;
     }
+    /* get_task_id_at as a pointer, for older callers. */
     weak_ptr<TASK> task_at(const Coord &coord)
     {
-        auto it = tasks.begin();
-        for (; it != tasks.end(); ++it)
+        int id = task_id_at(coord);
+        if (id < 0)
+            return weak_ptr<TASK>();
+        return tasks[id];
+    }
+    /* Forget every discovered task; they are re-discovered through update_coords. */
+    void clear_active_tasks()
+    {
+        for (auto &task : active_tasks)
         {
-            if ((*it)->coord == coord && !(*it)->is_done())
-                break;
+            active_index[task->id] = -1;
+            if (recording)
+                delta.tasks.push_back({MAP_DELTA::TASK_CHANGE::FORGOTTEN, task->id});
         }
-        if (it == tasks.end())
-            return weak_ptr<TASK>();
-        else
-            return (*it);
+        active_tasks.clear();
     }
-    set<Coord> observed_coord_by_robot()
+    /* The sets last returned by observed_coord_by_robot / update_coords. */
+    const CELL_BITMAP &last_observed() const { return observed_buffer; }
+    const CELL_BITMAP &last_updated() const { return updated_buffer; }
+    const CELL_BITMAP &observed_coord_by_robot()
     {
-        set<Coord> observed_coord_set;
+        CELL_BITMAP &observed_coord_set = observed_buffer;
+        observed_coord_set.clear();
         int viewrange;
         ROBOT::VIEWTYPE viewtype;
         int x;
         int y;
-        for (const auto robot : robots)
+        for (const auto &robot : robots)
         {
             if (robot->status == ROBOT::STATUS::EXHAUSTED)
                 continue;
@@ -431,33 +959,24 @@ public:
 
             if (viewtype == ROBOT::VIEWTYPE::CROSS)
             {
+                observed_coord_set.insert_column(x, y - viewrange, y + viewrange);
                 for (int xx = max(x - viewrange, 0); xx < min(x + viewrange + 1, map_size); ++xx)
                 {
                     observed_coord_set.emplace(xx, y);
                 }
-                for (int yy = max(y - viewrange, 0); yy < min(y + viewrange + 1, map_size); ++yy)
-                {
-                    observed_coord_set.emplace(x, yy);
-                }
             }
             else if (viewtype == ROBOT::VIEWTYPE::SQUARE)
             {
-                for (int xx = max(x - viewrange, 0); xx < min(x + viewrange + 1, map_size); ++xx)
-                {
-                    for (int yy = max(y - viewrange, 0); yy < min(y + viewrange + 1, map_size); ++yy)
-                    {
-                        observed_coord_set.emplace(xx, yy);
-                    }
-                }
+                observed_coord_set.insert_window(x - viewrange, x + viewrange, y - viewrange, y + viewrange);
             }
         }
         return observed_coord_set;
     }
-    set<Coord> update_coords(const set<Coord> &observed_coord_set)
+    const CELL_BITMAP &update_coords(const CELL_BITMAP &observed_coord_set)
     {
-        set<Coord> updated_coord_set;
+        CELL_BITMAP &updated_coord_set = updated_buffer;
         updated_coord_set = previous_update;
-        for (auto &coord : observed_coord_set)
+        for (const Coord coord : observed_coord_set)
         {
             auto &known_object = known_object_at(coord);
             auto &object = object_at(coord);
@@ -465,48 +984,48 @@ public:
             {
                 if (bool(~known_object & object & OBJECT::TASK))
                 {
-                    active_tasks.emplace_back(task_at(coord));
+                    add_active_task(tasks[task_id_at(coord)]);
 #ifdef VERBOSE
                     cout << "Task " << active_tasks.back()->id << " is found at " << coord << endl;
 #endif
                 }
                 if (known_object == OBJECT::UNKNOWN)
                 {
-                    known_cost_at(coord) = cost_at(coord);
+                    for (int t = 0; t < ROBOT::NUM_ROBOT_TYPE; ++t)
+                        known_cost_map.at(coord, t) = cost_map.at(coord, t);
                 }
                 known_object = object;
                 updated_coord_set.insert(coord);
+                if (recording)
+                    delta.revealed.push_back(coord);
             }
         }
         previous_update.clear();
         return updated_coord_set;
     }
-    bool complete_task(weak_ptr<TASK> weak_ptr_task)
+    bool complete_task(int task_id)
     {
-        auto task = weak_ptr_task.lock();
-        if (task->assigned_robot.lock()->remain_progress > 0)
+        TASK &task = *tasks[task_id];
+        if (robots[task.assigned_robot]->remain_progress > 0)
         {
-            cout << "Task " << task->id << task->coord << "is not complete" << endl;
+            cout << "Task " << task.id << task.coord << "is not complete" << endl;
             return false;
         }
 #ifdef VERBOSE
-        cout << "Task " << task->id << " at " << task->coord << " is completed by Robot " << task->assigned_robot.lock()->id << endl;
+        cout << "Task " << task.id << " at " << task.coord << " is completed by Robot " << task.assigned_robot << endl;
 #endif // VERBOSE
-        task->done = true;
-        for (auto it = active_tasks.begin(); it != active_tasks.end(); ++it)
-        {
-            if ((*it) == task)
-            {
-                active_tasks.erase(it);
-                break;
-            }
-        }
-        known_object_at(task->coord) = object_at(task->coord) &= ~OBJECT::TASK;
-        previous_update.insert(task->coord);
+        task.done = true;
+        remove_active_task(task);
+        task_id_at(task.coord) = -1;
+        known_object_at(task.coord) = object_at(task.coord) &= ~OBJECT::TASK;
+        previous_update.insert(task.coord);
         ++completed_task_num;
+        if (recording)
+            delta.tasks.push_back({MAP_DELTA::TASK_CHANGE::COMPLETED, task.id});
 
         return true;
     }
+    bool complete_task(weak_ptr<TASK> task) { return complete_task(task.lock()->id); }
 
     // Print methods
 
@@ -524,56 +1043,85 @@ private:
     int completed_task_num = 0;
     vector<shared_ptr<ROBOT>> robots;
     vector<shared_ptr<TASK>> tasks;
-    vector<vector<vector<int>>> cost_map;
-    vector<vector<OBJECT>> object_map;
-    vector<vector<int>> robot_num_map;
-    vector<vector<vector<int>>> known_cost_map;
-    vector<vector<OBJECT>> known_object_map;
-    vector<shared_ptr<TASK>> active_tasks;
-    set<Coord> previous_update;
+    GRID<int> cost_map;      // [type][x][y]
+    GRID<OBJECT> object_map;
+    GRID<int> robot_num_map;
+    GRID<int> known_cost_map; // [type][x][y], -1 until observed
+    GRID<OBJECT> known_object_map;
+    vector<shared_ptr<TASK>> active_tasks; // unordered; see remove_active_task
+    vector<int> active_index;             // [task id] position in active_tasks, -1 if absent
+    GRID<int> task_id_map;                // id of the undone task on each cell, -1 if none
+    CELL_BITMAP previous_update;
+    CELL_BITMAP observed_buffer; // returned by observed_coord_by_robot
+    CELL_BITMAP updated_buffer;  // returned by update_coords
+    mutable RNG rng;             // every random draw of this simulation
+    bool recording = false;      // fill delta
+    MAP_DELTA delta;
 
     // At methods
-    OBJECT &object_at(int x, int y) { return object_map[x][y]; }
-    const OBJECT object_at(int x, int y) const { return object_map[x][y]; }
-    OBJECT &object_at(Coord coord) { return object_map[coord.x][coord.y]; }
-    const OBJECT object_at(Coord coord) const { return object_map[coord.x][coord.y]; }
-    OBJECT &known_object_at(Coord coord) { return known_object_map[coord.x][coord.y]; }
-    const OBJECT known_object_at(Coord coord) const { return known_object_map[coord.x][coord.y]; }
-    OBJECT &known_object_at(int x, int y) { return known_object_map[x][y]; }
-    const OBJECT known_object_at(int x, int y) const { return known_object_map[x][y]; }
-    vector<int> &cost_at(Coord coord) { return cost_map[coord.x][coord.y]; }
-    const vector<int> &cost_at(Coord coord) const { return cost_map[coord.x][coord.y]; }
-    int &cost_at(Coord coord, ROBOT::TYPE type) { return cost_at(coord)[static_cast<size_t>(type)]; }
+    OBJECT &object_at(int x, int y) { return object_map.at(x, y); }
+    const OBJECT object_at(int x, int y) const { return object_map.at(x, y); }
+    OBJECT &object_at(Coord coord) { return object_map.at(coord); }
+    const OBJECT object_at(Coord coord) const { return object_map.at(coord); }
+    OBJECT &known_object_at(Coord coord) { return known_object_map.at(coord); }
+    const OBJECT known_object_at(Coord coord) const { return known_object_map.at(coord); }
+    OBJECT &known_object_at(int x, int y) { return known_object_map.at(x, y); }
+    const OBJECT known_object_at(int x, int y) const { return known_object_map.at(x, y); }
+    int &cost_at(Coord coord, ROBOT::TYPE type) { return cost_map.at(coord, static_cast<int>(type)); }
     int &cost_at(const ROBOT &robot) { return cost_at(robot.coord, robot.type); }
-    int cost_at(Coord coord, ROBOT::TYPE type) const { return cost_at(coord)[static_cast<size_t>(type)]; }
+    int cost_at(Coord coord, ROBOT::TYPE type) const { return cost_map.at(coord, static_cast<int>(type)); }
     int cost_at(const ROBOT &robot) const { return cost_at(robot.coord, robot.type); }
-    vector<int> &known_cost_at(const Coord &coord) { return known_cost_map[coord.x][coord.y]; }
-    const vector<int> &known_cost_at(const Coord &coord) const { return known_cost_map[coord.x][coord.y]; }
-    int &known_cost_at(const Coord &coord, ROBOT::TYPE type) { return known_cost_map[coord.x][coord.y][static_cast<size_t>(type)]; }
-    int known_cost_at(const Coord &coord, ROBOT::TYPE type) const { return known_cost_map[coord.x][coord.y][static_cast<size_t>(type)]; }
-    int &robot_num_at(const Coord &coord) { return robot_num_map[coord.x][coord.y]; }
+    int &known_cost_at(const Coord &coord, ROBOT::TYPE type) { return known_cost_map.at(coord, static_cast<int>(type)); }
+    int known_cost_at(const Coord &coord, ROBOT::TYPE type) const { return known_cost_map.at(coord, static_cast<int>(type)); }
+    int &robot_num_at(const Coord &coord) { return robot_num_map.at(coord); }
+    int &task_id_at(const Coord &coord) { return task_id_map.at(coord); }
+
+    // Active task set
+    void add_active_task(const shared_ptr<TASK> &task)
+    {
+        active_index[task->id] = static_cast<int>(active_tasks.size());
+        active_tasks.push_back(task);
+        if (recording)
+            delta.tasks.push_back({MAP_DELTA::TASK_CHANGE::DISCOVERED, task->id});
+    }
+    // Swap the last entry into the hole, so removal is O(1) and the set does
+    // not keep discovery order.
+    void remove_active_task(const TASK &task)
+    {
+        int pos = active_index[task.id];
+        if (pos < 0)
+            return;
+        active_tasks[pos] = active_tasks.back();
+        active_index[active_tasks[pos]->id] = pos;
+        active_tasks.pop_back();
+        active_index[task.id] = -1;
+    }
 
     // Map generate
     void generate_map(int num_robot, int num_initial_task, int robot_energy)
     {
         // resize map;
-        cost_map = vector<vector<vector<int>>>(map_size, vector<vector<int>>(map_size, vector<int>(ROBOT::NUM_ROBOT_TYPE)));
-        object_map = vector<vector<OBJECT>>(map_size, vector<OBJECT>(map_size, OBJECT::EMPTY));
-        robot_num_map = vector<vector<int>>(map_size, vector<int>(map_size, 0));
-        known_cost_map = vector<vector<vector<int>>>(map_size, vector<vector<int>>(map_size, vector<int>(ROBOT::NUM_ROBOT_TYPE, -1)));
-        known_object_map = vector<vector<OBJECT>>(map_size, vector<OBJECT>(map_size, OBJECT::UNKNOWN));
+        cost_map = GRID<int>(map_size, ROBOT::NUM_ROBOT_TYPE, 0);
+        object_map = GRID<OBJECT>(map_size, 1, OBJECT::EMPTY);
+        robot_num_map = GRID<int>(map_size, 1, 0);
+        known_cost_map = GRID<int>(map_size, ROBOT::NUM_ROBOT_TYPE, -1);
+        known_object_map = GRID<OBJECT>(map_size, 1, OBJECT::UNKNOWN);
+        task_id_map = GRID<int>(map_size, 1, -1);
+        previous_update = CELL_BITMAP(map_size);
+        observed_buffer = CELL_BITMAP(map_size);
+        updated_buffer = CELL_BITMAP(map_size);
 
         // generate terrein
-        int droneCost = (rand() % 40 + 60) * 2;
+        int droneCost = (rng() % 40 + 60) * 2;
         int tempCost;
         for (int xx = 0; xx < map_size; ++xx)
         {
             for (int yy = 0; yy < map_size; ++yy)
             {
-                cost_map[xx][yy][0] = droneCost;
-                tempCost = (rand() % 200);
-                cost_map[xx][yy][1] = tempCost * 2 + 100;
-                cost_map[xx][yy][2] = tempCost * 4 + 50;
+                cost_map.at(xx, yy, 0) = droneCost;
+                tempCost = (rng() % 200);
+                cost_map.at(xx, yy, 1) = tempCost * 2 + 100;
+                cost_map.at(xx, yy, 2) = tempCost * 4 + 50;
             }
         }
 
@@ -584,11 +1132,11 @@ private:
             auto coord = get_random_empty_coord();
             int x = coord.x;
             int y = coord.y;
-            object_map[x][y] = OBJECT::WALL;
+            object_map.at(x, y) = OBJECT::WALL;
             for (int t = 0; t < ROBOT::NUM_ROBOT_TYPE; ++t)
             {
-                cost_map[x][y][t] = INFINITE;
-                object_map[x][y] = OBJECT::WALL;
+                cost_map.at(x, y, t) = INFINITE;
+                object_map.at(x, y) = OBJECT::WALL;
             }
         }
 
@@ -0,0 +1,102 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool for fork/join loops.  run(n, fn) calls fn(i, thread) once for
+// every i in [0, n) and returns when all of them are done; the calling thread
+// takes part as thread 0, so `thread` is always below size() and can index
+// per-thread scratch.  Items are handed out one at a time from a shared
+// counter, so which thread runs an item is not deterministic -- callers that
+// need a deterministic result write per-item output and combine it in item
+// order afterwards.
+//
+// A pool of one thread (or fewer) starts nothing and runs every loop inline.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int threads)
+    {
+        for (int i = 1; i < threads; ++i)
+            workers.emplace_back([this, i] { loop(i); });
+    }
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    void run(int n, const std::function<void(int, int)> &fn)
+    {
+        if (workers.empty() || n <= 1)
+        {
+            for (int i = 0; i < n; ++i)
+                fn(i, 0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(m);
+            job = &fn;
+            total = n;
+            next = 0;
+            busy = static_cast<int>(workers.size());
+            ++generation;
+        }
+        wake.notify_all();
+        drain(0);
+        std::unique_lock<std::mutex> lk(m);
+        done.wait(lk, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    void drain(int thread)
+    {
+        for (int i; (i = next.fetch_add(1)) < total;)
+            (*job)(i, thread);
+    }
+    void loop(int thread)
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lk(m);
+                wake.wait(lk, [&] { return stop || generation != seen; });
+                if (stop)
+                    return;
+                seen = generation;
+            }
+            drain(thread);
+            std::lock_guard<std::mutex> lk(m);
+            if (--busy == 0)
+                done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable wake, done;
+    const std::function<void(int, int)> *job = nullptr;
+    std::atomic<int> next{0};
+    int total = 0;
+    int busy = 0;
+    unsigned long long generation = 0;
+    bool stop = false;
+};
+
+#endif // THREAD_POOL_H_
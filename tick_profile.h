@@ -0,0 +1,88 @@
+#ifndef TICK_PROFILE_H_
+#define TICK_PROFILE_H_
+
+#include <chrono>
+
+// Where one on_info_updated call spent its time, phase by phase, plus a few
+// work counters.  Phases are timed as laps: start() at the top of the call,
+// then lap(P) at the end of each phase charges the time since the previous
+// lap to P, so the phases add up to the whole call and timing one costs a
+// single clock read.  Everything is cleared by start(); a tick's numbers are
+// valid until the next call.
+class TickProfile
+{
+public:
+    enum Phase
+    {
+        UPDATE,         // lazy init, known-map update, task snapshot
+        EDGE_VAL,       // staleness, observation mass and edge value grids
+                        // (staleness is lapped after SERVE_DIST, which it needs)
+        ROBOT_DIJKSTRA, // per-robot distance fields
+        SERVER_COUNT,   // workers able to serve each task, planning workers
+        EXACT_DP,       // exact subset plan and its reconstruction
+        INSERTION,      // seeding from last tick and cheapest insertion
+        LOCAL_SEARCH,   // relocate / swap / 2-opt
+        HANDOFF,        // first legs handed to the workers
+        SERVE_DIST,     // cheapest worker reach per cell
+        DRONES,         // drone sweep targets
+        PATROL,         // idle-worker patrol
+        NUM_PHASES
+    };
+    enum Counter
+    {
+        HEAP_PUSHES,    // bucket queue and LPA* heap pushes
+        DIJKSTRA_RUNS,  // full searches
+        LPA_REPAIRS,    // incremental repairs of a kept field
+        TASK_MAP_HITS,  // dist_from_task served from its cache as is
+        TASK_MAP_MISSES,// dist_from_task built or repaired
+        EXACT_STATES,   // exact DP states expanded
+        NUM_COUNTERS
+    };
+
+    static const char *phase_name(int p)
+    {
+        static const char *const names[NUM_PHASES] = {"update", "edge_val", "robot_dijkstra", "server_count",
+                                                      "exact_dp", "insertion", "local_search", "handoff",
+                                                      "serve_dist", "drones", "patrol"};
+        return names[p];
+    }
+    static const char *counter_name(int c)
+    {
+        static const char *const names[NUM_COUNTERS] = {"heap_pushes", "dijkstra_runs", "lpa_repairs",
+                                                        "task_map_hits", "task_map_misses", "exact_states"};
+        return names[c];
+    }
+
+    void start()
+    {
+        for (int p = 0; p < NUM_PHASES; ++p)
+            phase_ns[p] = 0;
+        for (int c = 0; c < NUM_COUNTERS; ++c)
+            counters[c] = 0;
+        last = std::chrono::steady_clock::now();
+    }
+    void lap(Phase p)
+    {
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+        phase_ns[p] += std::chrono::duration_cast<std::chrono::nanoseconds>(t - last).count();
+        last = t;
+    }
+    void add(Counter c, long long v = 1) { counters[c] += v; }
+
+    long long ns(int p) const { return phase_ns[p]; }
+    long long count(int c) const { return counters[c]; }
+    long long total_ns() const
+    {
+        long long t = 0;
+        for (int p = 0; p < NUM_PHASES; ++p)
+            t += phase_ns[p];
+        return t;
+    }
+
+private:
+    long long phase_ns[NUM_PHASES] = {};
+    long long counters[NUM_COUNTERS] = {};
+    std::chrono::steady_clock::time_point last;
+};
+
+#endif // TICK_PROFILE_H_